@@ -22,6 +22,14 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 #include <iostream>
+#include <exception>
+#include <memory>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <new>
+#include <cstddef>
 
 namespace array {
 	typedef size_t index_t;
@@ -38,185 +46,572 @@ namespace array {
 		{obj1 < obj2} noexcept -> std::convertible_to<bool>;
 	};
 
+	// Fixed-length array stored inline, like std::array: it is an aggregate, so
+	// Array<int, 3> a = { 1, 2, 3 } is brace-initialized without a constructor,
+	// copies are member-wise and it is trivially copyable whenever type is.
+	// elems is public only because aggregates cannot have private members.
 	template <typename type, size_t length> class Array final {
-		class Iterator {
-			type* m_ptr = nullptr;
+		template <typename value_t> class Iterator {
+			value_t* m_ptr = nullptr;
 		public:
-			Iterator(type* ptr) : m_ptr(ptr) {}
+			constexpr Iterator(value_t* ptr) : m_ptr(ptr) {}
 
-			type& operator * () const {
+			constexpr value_t& operator * () const {
 				return *m_ptr;
 			}
-			Iterator& operator ++ () {
+			constexpr Iterator& operator ++ () {
 				m_ptr++;
 				return *this;
 			}
-			Iterator operator ++ (int) {
+			constexpr Iterator operator ++ (int) {
 				Iterator temp = *this;
 				m_ptr++;
 				return temp;
 			}
-			friend bool operator == (const Iterator& a, const Iterator& b) {
+			friend constexpr bool operator == (const Iterator& a, const Iterator& b) {
 				return a.m_ptr == b.m_ptr;
 			}
-			friend bool operator != (const Iterator& a, const Iterator& b) {
+			friend constexpr bool operator != (const Iterator& a, const Iterator& b) {
 				return a.m_ptr != b.m_ptr;
 			}
 		};
 
-		type* base;
-	public:
-		explicit Array(void) {
-			base = static_cast<type*>(calloc(length, sizeof(type)));
-		}
-		Array(std::initializer_list<type> const& list) {
-			base = static_cast<type*>(calloc(length, sizeof(type)));
-			for (size_t i = 0; i < length; i++) {
-				operator[](i) = *(list.begin() + i);
+		// The bulk operations below index elems directly and keep their inner
+		// loops free of early exits where they can, so the compiler turns them
+		// into SIMD code for arithmetic types. Searches check a block of
+		// elements at a time and only look for the exact position once a block
+		// has a hit. The mem* shortcuts are skipped during constant evaluation.
+		static constexpr size_t block_length = (sizeof(type) < 64) ? 64 / sizeof(type) : 1;
+		// scalars other than floating point compare equal exactly when their
+		// bytes do; class types may define == any way they like, and floating
+		// point has +0 == -0 and NaN != NaN
+		static constexpr bool is_bitwise_comparable = (std::is_integral_v<type> ||
+			std::is_enum_v<type> || std::is_pointer_v<type>) && std::has_unique_object_representations_v<type>;
+		// byte-sized types that the mem* functions see exactly as == does
+		static constexpr bool is_byte = sizeof(type) == 1 && is_bitwise_comparable;
+		// types whose order is the order of their bytes as unsigned chars
+		static constexpr bool is_bytewise_ordered = std::is_same_v<type, unsigned char> ||
+			std::is_same_v<type, std::byte> || std::is_same_v<type, char8_t> ||
+			(std::is_same_v<type, char> && !std::is_signed_v<char>);
+
+		// index of the first element of lhs that is not equal to the one in rhs
+		// at the same position, length if there is none
+		static constexpr size_t mismatch(const type* lhs, const type* rhs) {
+			size_t i = 0;
+			if constexpr (std::is_arithmetic_v<type>) {
+				for (; i + block_length <= length; i += block_length) {
+					bool hit = false;
+					for (size_t j = 0; j < block_length; j++)
+						hit |= !(lhs[i + j] == rhs[i + j]);
+					if (hit)
+						break;
+				}
 			}
+			for (; i < length; i++) {
+				if (!(lhs[i] == rhs[i]))
+					break;
+			}
+			return i;
 		}
-		~Array() {
-			free((void*)base);
-		}
-		type& at(size_t n) {
+	public:
+		// a zero-length array still holds one element, as arrays cannot be empty
+		type elems[(length) ? length : 1];
+
+		constexpr type& at(size_t n) {
 			return operator[](n);
 		}
-		const type& at(size_t n) const {
+		constexpr const type& at(size_t n) const {
 			return operator[](n);
 		}
 		
-		type& back() {
-			return *(base + length - 1);
+		constexpr type& back() {
+			return elems[length - 1];
 		}
-		const type& back() const {
-			return *(base + length - 1);
+		constexpr const type& back() const {
+			return elems[length - 1];
 		}
 
-		Iterator begin() noexcept {
-			return Iterator(base);
+		constexpr Iterator<type> begin() noexcept {
+			return Iterator<type>(elems);
 		}
-		const Iterator begin() const noexcept {
-			return Iterator(base);
+		constexpr Iterator<const type> begin() const noexcept {
+			return Iterator<const type>(elems);
+		}
+		constexpr Iterator<type> end() noexcept {
+			return Iterator<type>(elems + length);
+		}
+		constexpr Iterator<const type> end() const noexcept {
+			return Iterator<const type>(elems + length);
 		}
 
-		type* data() {
-			return base;
+		constexpr size_t count(const type& obj) const {
+			size_t n = 0;
+			for (size_t i = 0; i < length; i++)
+				n += (elems[i] == obj);
+			return n;
 		}
-		const type* data() const {
-			return base;
+
+		constexpr type* data() noexcept {
+			return elems;
+		}
+		constexpr const type* data() const noexcept {
+			return elems;
 		}
 
-		constexpr bool empty() noexcept {
-			return length;
+		constexpr bool empty() const noexcept {
+			return !length;
 		}
 
-		void fill(const type& val) {
-			type* addr = base;
-			for (size_t i = 0; i < length; i++) {
-				*(addr + i) = val;
+		constexpr void fill(const type& val) {
+			if constexpr (is_byte) {
+				if (!std::is_constant_evaluated()) {
+					memset(elems, static_cast<unsigned char>(val), length);
+					return;
+				}
 			}
+			for (size_t i = 0; i < length; i++)
+				elems[i] = val;
 		}
 
-		type& front() {
-			return *base;
+		// index of the first element equal to obj, length if there is none
+		constexpr size_t find(const type& obj) const {
+			if constexpr (is_byte) {
+				if (!std::is_constant_evaluated()) {
+					const void* addr = memchr(elems, static_cast<unsigned char>(obj), length);
+					return (addr) ? static_cast<size_t>(static_cast<const unsigned char*>(addr) - reinterpret_cast<const unsigned char*>(elems)) : length;
+				}
+			}
+			size_t i = 0;
+			if constexpr (std::is_arithmetic_v<type>) {
+				for (; i + block_length <= length; i += block_length) {
+					bool hit = false;
+					for (size_t j = 0; j < block_length; j++)
+						hit |= (elems[i + j] == obj);
+					if (hit)
+						break;
+				}
+			}
+			for (; i < length; i++) {
+				if (elems[i] == obj)
+					break;
+			}
+			return i;
 		}
-		const type& front() const {
-			return *base;
+
+		constexpr type& front() {
+			return elems[0];
+		}
+		constexpr const type& front() const {
+			return elems[0];
+		}
+
+		constexpr bool has(const type& obj) const {
+			return find(obj) != length;
 		}
 
-		bool has(type& obj) const {
-			for (size_t i = 0; i < size(); i++) {
-				if (operator[](i) == obj) {
-					return true;
+		// the first of the largest elements
+		constexpr const type& max() const {
+			if (!length)
+				throw array::out_of_range();
+			if constexpr (std::is_integral_v<type>) {
+				type best = elems[0];
+				for (size_t i = 1; i < length; i++)
+					best = (best < elems[i]) ? elems[i] : best;
+				return elems[find(best)];
+			}
+			else {
+				size_t best = 0;
+				for (size_t i = 1; i < length; i++) {
+					if (elems[best] < elems[i])
+						best = i;
 				}
+				return elems[best];
 			}
-			return false;
 		}
 
 		constexpr size_t max_size() const noexcept {
 			return length;
 		}
 
+		// the first of the smallest elements
+		constexpr const type& min() const {
+			if (!length)
+				throw array::out_of_range();
+			if constexpr (std::is_integral_v<type>) {
+				type best = elems[0];
+				for (size_t i = 1; i < length; i++)
+					best = (elems[i] < best) ? elems[i] : best;
+				return elems[find(best)];
+			}
+			else {
+				size_t best = 0;
+				for (size_t i = 1; i < length; i++) {
+					if (elems[i] < elems[best])
+						best = i;
+				}
+				return elems[best];
+			}
+		}
+
 		constexpr size_t size() const noexcept {
 			return length;
 		}
 
-		template <typename Array_T> requires std::same_as<Array_T, Array> && requires(Array_T obj) {
-			{ obj.max_size() } noexcept -> std::convertible_to<size_t>;
-			requires obj.max_size() == length;
-		} void swap(Array_T& x) {
-			for (size_t i = 0; i < length; i++) {
-				type tmp = operator[](i);
-				at(i) = x[i];
-				x[i] = tmp;
-			}
+		constexpr void swap(Array& x) noexcept(std::is_nothrow_swappable_v<type>) {
+			for (size_t i = 0; i < length; i++)
+				std::swap(elems[i], x.elems[i]);
 		}
 
-		type& operator [] (size_t n) {
+		// element access without the bounds check of operator []
+		constexpr type& unchecked_at(size_t n) noexcept {
+			return elems[n];
+		}
+		constexpr const type& unchecked_at(size_t n) const noexcept {
+			return elems[n];
+		}
+
+		constexpr type& operator [] (size_t n) {
 			if (n >= length)
 				throw array::out_of_range();
-			return *(base + n);
+			return elems[n];
 		}
-		const type& operator [] (size_t n) const {
+		constexpr const type& operator [] (size_t n) const {
 			if (n >= length)
 				throw array::out_of_range();
-			return *(base + n);
+			return elems[n];
 		}
 
-		template <typename T, size_t N> friend bool operator == (const Array<T, N>& lhs, const Array<T, N>& rhs) {
-			for (size_t i = 0; i < N; i++) {
-				if (lhs[i] != rhs[i]) {
-					return false;
-				}
+		friend constexpr bool operator == (const Array& lhs, const Array& rhs) {
+			if constexpr (is_bitwise_comparable) {
+				if (!std::is_constant_evaluated())
+					return !memcmp(lhs.elems, rhs.elems, length * sizeof(type));
 			}
-			return true;
+			return mismatch(lhs.elems, rhs.elems) == length;
 		}
-		template <typename T, size_t N> friend bool operator != (const Array<T, N>& lhs, const Array<T, N>& rhs) {
-			for (size_t i = 0; i < N; i++) {
-				if (lhs[i] == rhs[i]) {
-					return false;
-				}
+		friend constexpr bool operator != (const Array& lhs, const Array& rhs) {
+			return !(lhs == rhs);
+		}
+		// lexicographic order, decided by the first pair of elements that differ
+		friend constexpr bool operator <  (const Array& lhs, const Array& rhs) requires supports_comparison<type> {
+			if constexpr (is_bytewise_ordered) {
+				if (!std::is_constant_evaluated())
+					return memcmp(lhs.elems, rhs.elems, length) < 0;
 			}
-			return true;
+			size_t i = mismatch(lhs.elems, rhs.elems);
+			return i != length && lhs.elems[i] < rhs.elems[i];
+		}
+		friend constexpr bool operator >  (const Array& lhs, const Array& rhs) requires supports_comparison<type> {
+			return rhs < lhs;
+		}
+		friend constexpr bool operator <= (const Array& lhs, const Array& rhs) requires supports_comparison<type> {
+			return !(rhs < lhs);
 		}
-		template <typename T, size_t N> requires supports_comparison<T>
-		friend bool operator <= (const Array<T, N>& lhs, const Array<T, N>& rhs) {
-			for (size_t i = 0; i < N; i++) {
-				if (lhs[i] != rhs[i] || lhs[i] > rhs[i]) {
-					return false;
+		friend constexpr bool operator >= (const Array& lhs, const Array& rhs) requires supports_comparison<type> {
+			return !(lhs < rhs);
+		}
+	};
+
+	// Growable contiguous array. The capacity doubles whenever it runs out and
+	// elements of trivially copyable types are relocated with a single memcpy
+	// instead of being moved one by one. The first inline_capacity elements are
+	// stored inside the object itself, so a SmallVector only goes to the heap
+	// once it outgrows that buffer.
+	template <typename type, size_t inline_capacity = 0> class Vector final {
+		alignas(type) unsigned char buffer[(inline_capacity) ? inline_capacity * sizeof(type) : 1];
+		type* base_addr = reinterpret_cast<type*>(buffer);
+		size_t length = 0;
+		size_t capacity_v = inline_capacity;
+
+		bool is_inline() const noexcept {
+			return base_addr == reinterpret_cast<const type*>(buffer);
+		}
+		// moves the elements to a block of the given capacity, which must be at
+		// least length; a capacity that fits the inline buffer moves them back
+		void relocate(size_t capacity) {
+			type* addr = (capacity > inline_capacity) ?
+				std::allocator<type>().allocate(capacity) :
+				reinterpret_cast<type*>(buffer);
+			if (addr == base_addr)
+				return;
+			if constexpr (std::is_trivially_copyable_v<type>) {
+				if (length)
+					memcpy(static_cast<void*>(addr), static_cast<const void*>(base_addr), length * sizeof(type));
+			}
+			else {
+				for (index_t i = 0; i < length; i++) {
+					new (addr + i) type(std::move(base_addr[i]));
+					base_addr[i].~type();
 				}
 			}
-			return true;
+			if (!is_inline())
+				std::allocator<type>().deallocate(base_addr, capacity_v);
+			base_addr = addr;
+			capacity_v = std::max(capacity, inline_capacity);
 		}
-		template <typename T, size_t N> requires supports_comparison<T>
-		friend bool operator >= (const Array<T, N>& lhs, const Array<T, N>& rhs) {
-			for (size_t i = 0; i < N; i++) {
-				if (lhs[i] != rhs[i] || lhs[i] < rhs[i]) {
-					return false;
-				}
+		void grow() {
+			relocate((capacity_v) ? capacity_v * 2 : 8);
+		}
+	public:
+		typedef type* Iterator;
+		typedef const type* ConstIterator;
+
+		Vector(void) = default;
+		explicit Vector(size_t count) {
+			resize(count);
+		}
+		Vector(size_t count, const type& obj) {
+			resize(count, obj);
+		}
+		Vector(std::initializer_list<type> const& list) {
+			reserve(list.size());
+			for (auto const& obj : list) {
+				new (base_addr + length) type(obj);
+				length++;
 			}
-			return true;
 		}
-		template <typename T, size_t N> requires supports_comparison<T>
-		friend bool operator <  (const Array<T, N>& lhs, const Array<T, N>& rhs) {
-			for (size_t i = 0; i < N; i++) {
-				if (lhs[i] == rhs[i] || lhs[i] > rhs[i]) {
-					return false;
-				}
+		Vector(Vector const& obj) {
+			reserve(obj.length);
+			for (index_t i = 0; i < obj.length; i++)
+				new (base_addr + i) type(obj.base_addr[i]);
+			length = obj.length;
+		}
+		Vector(Vector&& obj) noexcept {
+			*this = std::move(obj);
+		}
+		Vector& operator = (Vector const& obj) {
+			if (this != &obj) {
+				clear();
+				reserve(obj.length);
+				for (index_t i = 0; i < obj.length; i++)
+					new (base_addr + i) type(obj.base_addr[i]);
+				length = obj.length;
 			}
-			return true;
+			return *this;
 		}
-		template <typename T, size_t N> requires supports_comparison<T>
-		friend bool operator >  (const Array<T, N>& lhs, const Array<T, N>& rhs) {
-			for (size_t i = 0; i < N; i++) {
-				if (lhs[i] == rhs[i] || lhs[i] < rhs[i]) {
-					return false;
+		Vector& operator = (Vector&& obj) noexcept {
+			if (this == &obj)
+				return *this;
+			clear();
+			if (!obj.is_inline()) {
+				if (!is_inline())
+					std::allocator<type>().deallocate(base_addr, capacity_v);
+				base_addr = obj.base_addr;
+				capacity_v = obj.capacity_v;
+				length = obj.length;
+				obj.base_addr = reinterpret_cast<type*>(obj.buffer);
+				obj.capacity_v = inline_capacity;
+				obj.length = 0;
+				return *this;
+			}
+			// an inline vector holds at most inline_capacity elements, which
+			// always fit into whatever this one has
+			for (index_t i = 0; i < obj.length; i++)
+				new (base_addr + i) type(std::move(obj.base_addr[i]));
+			length = obj.length;
+			obj.clear();
+			return *this;
+		}
+		~Vector() {
+			clear();
+			if (!is_inline())
+				std::allocator<type>().deallocate(base_addr, capacity_v);
+		}
+
+		type& at(size_t n) {
+			return operator[](n);
+		}
+		const type& at(size_t n) const {
+			return operator[](n);
+		}
+
+		type& back() {
+			if (!length)
+				throw array::out_of_range();
+			return base_addr[length - 1];
+		}
+		const type& back() const {
+			if (!length)
+				throw array::out_of_range();
+			return base_addr[length - 1];
+		}
+
+		Iterator begin() noexcept {
+			return base_addr;
+		}
+		ConstIterator begin() const noexcept {
+			return base_addr;
+		}
+		Iterator end() noexcept {
+			return base_addr + length;
+		}
+		ConstIterator end() const noexcept {
+			return base_addr + length;
+		}
+
+		size_t capacity() const noexcept {
+			return capacity_v;
+		}
+
+		void clear() noexcept {
+			if constexpr (!std::is_trivially_destructible_v<type>) {
+				for (index_t i = 0; i < length; i++)
+					base_addr[i].~type();
+			}
+			length = 0;
+		}
+
+		type* data() noexcept {
+			return base_addr;
+		}
+		const type* data() const noexcept {
+			return base_addr;
+		}
+
+		template <typename... args_t> type& emplace_back(args_t&&... args) {
+			if (length == capacity_v) {
+				// args may refer to an element of this vector, so the new one is
+				// constructed before the old block goes away
+				if constexpr (sizeof...(args_t)) {
+					type obj(std::forward<args_t>(args)...);
+					grow();
+					new (base_addr + length) type(std::move(obj));
+					return base_addr[length++];
 				}
+				else
+					grow();
+			}
+			type* addr = new (base_addr + length) type(std::forward<args_t>(args)...);
+			length++;
+			return *addr;
+		}
+		// constructs an element at index, shifting the ones after it up by one
+		template <typename... args_t> type& emplace(index_t index, args_t&&... args) {
+			if (index > length)
+				throw array::out_of_range();
+			emplace_back(std::forward<args_t>(args)...);
+			std::rotate(base_addr + index, base_addr + length - 1, base_addr + length);
+			return base_addr[index];
+		}
+
+		bool empty() const noexcept {
+			return !length;
+		}
+
+		void erase(index_t index) {
+			if (index >= length)
+				throw array::out_of_range();
+			std::move(base_addr + index + 1, base_addr + length, base_addr + index);
+			pop_back();
+		}
+
+		type& front() {
+			if (!length)
+				throw array::out_of_range();
+			return base_addr[0];
+		}
+		const type& front() const {
+			if (!length)
+				throw array::out_of_range();
+			return base_addr[0];
+		}
+
+		bool has(const type& obj) const {
+			return std::find(begin(), end(), obj) != end();
+		}
+
+		void insert(index_t index, type const& obj) {
+			emplace(index, obj);
+		}
+		void insert(index_t index, type&& obj) {
+			emplace(index, std::move(obj));
+		}
+
+		void pop_back() {
+			if (!length)
+				throw array::out_of_range();
+			length--;
+			base_addr[length].~type();
+		}
+
+		void push_back(type const& obj) {
+			emplace_back(obj);
+		}
+		void push_back(type&& obj) {
+			emplace_back(std::move(obj));
+		}
+
+		void reserve(size_t size) {
+			if (size > capacity_v)
+				relocate(size);
+		}
+
+		void resize(size_t size) {
+			reserve(size);
+			while (length > size)
+				pop_back();
+			for (; length < size; length++)
+				new (base_addr + length) type();
+		}
+		void resize(size_t size, const type& obj) {
+			reserve(size);
+			while (length > size)
+				pop_back();
+			for (; length < size; length++)
+				new (base_addr + length) type(obj);
+		}
+
+		void shrink_to_fit() {
+			if (length < capacity_v)
+				relocate(length);
+		}
+
+		size_t size() const noexcept {
+			return length;
+		}
+
+		void swap(Vector& obj) noexcept {
+			// only heap blocks can change hands, inline elements have to move
+			if (!is_inline() && !obj.is_inline()) {
+				std::swap(base_addr, obj.base_addr);
+				std::swap(length, obj.length);
+				std::swap(capacity_v, obj.capacity_v);
+			}
+			else {
+				Vector temp = std::move(obj);
+				obj = std::move(*this);
+				*this = std::move(temp);
 			}
-			return true;
+		}
+
+		type& operator [] (size_t n) {
+			if (n >= length)
+				throw array::out_of_range();
+			return base_addr[n];
+		}
+		const type& operator [] (size_t n) const {
+			if (n >= length)
+				throw array::out_of_range();
+			return base_addr[n];
+		}
+
+		friend bool operator == (const Vector& lhs, const Vector& rhs) {
+			return lhs.length == rhs.length && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+		}
+		friend bool operator != (const Vector& lhs, const Vector& rhs) {
+			return !(lhs == rhs);
+		}
+		friend auto operator << (std::ostream& os, Vector const& obj) -> std::ostream& {
+			os << "[";
+			for (index_t i = 0; i < obj.length; i++)
+				os << obj.base_addr[i] << ((i == obj.length - 1) ? "" : ", ");
+			os << "]";
+			return os;
 		}
 	};
 
+	template <typename type, size_t inline_capacity = 16>
+	using SmallVector = Vector<type, inline_capacity>;
+
 	template <typename type> class CircularArray final {
 		type* base;
 		size_t length = 0;
@@ -0,0 +1,435 @@
+﻿/*
+Copyright © 2017-2022 Yılmaz Alpaslan
+
+Permission is hereby granted, free of charge to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify,
+merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to the following
+conditions:
+
+The above copyright notice and this permission notice shall be included in all copies
+or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+PARTICULAR PURPOSE AND NOINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <iostream>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <mutex>
+#include <new>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+
+#include "hashmap.h"
+
+namespace cache {
+	typedef uint32_t index_t;
+
+	using queue::cache_line_size;
+
+	struct capacity_error : public std::exception {
+		virtual const char* what() const noexcept {
+			return "Cache capacity must be between 1 and 2^30";
+		}
+	};
+
+	enum class Policy {
+		// evicts the entry that was used least recently
+		LRU,
+		// second chance: a hit only sets a bit, and the eviction hand clears bits
+		// until it finds an entry that was not used since its last pass
+		CLOCK
+	};
+
+	struct Stats {
+		size_t hits = 0;
+		size_t misses = 0;
+		size_t evictions = 0;
+
+		Stats& operator += (Stats const& obj) noexcept {
+			hits += obj.hits;
+			misses += obj.misses;
+			evictions += obj.evictions;
+			return *this;
+		}
+	};
+
+	template <typename key_t, typename value_t, Policy policy, typename hash_t, typename equal_t>
+	class ShardedCache;
+
+	// Fixed-capacity cache. Entries, their recency links and the hash index all
+	// live in one allocation made by the constructor: links are 32-bit entry
+	// indices and the index is a linear-probing table of entry indices kept at
+	// most half full, so lookups and evictions never allocate. Live entries are
+	// always packed at the front of the slab.
+	template <typename key_t, typename value_t, Policy policy = Policy::LRU,
+		typename hash_t = std::hash<key_t>, typename equal_t = std::equal_to<key_t>>
+	class Cache final {
+		friend class ShardedCache<key_t, value_t, policy, hash_t, equal_t>;
+
+		struct Entry {
+			key_t key;
+			value_t value;
+			uint64_t hash;
+			// neighbours in recency order, towards the most and the least recently
+			// used end; unused by CLOCK
+			index_t prv;
+			index_t ptr;
+			bool referenced;
+		};
+		static constexpr index_t null_index = UINT32_MAX;
+		static constexpr size_t no_slot = SIZE_MAX;
+
+		Entry* entries = nullptr;
+		index_t* slots = nullptr;
+		size_t capacity_v = 0;
+		size_t mask = 0;
+		size_t length = 0;
+		index_t head = null_index;
+		index_t tail = null_index;
+		size_t hand = 0;
+		Stats counters;
+		hash_t hasher;
+		equal_t equal;
+
+		uint64_t hash_of(key_t const& key) const {
+			return hashmap::mix_hash(static_cast<uint64_t>(hasher(key)));
+		}
+		size_t find_slot(key_t const& key, uint64_t hash) const {
+			for (size_t i = hash & mask;; i = (i + 1) & mask) {
+				index_t e = slots[i];
+				if (e == null_index)
+					return no_slot;
+				if (entries[e].hash == hash && equal(entries[e].key, key))
+					return i;
+			}
+		}
+		size_t slot_of(index_t e) const noexcept {
+			size_t i = entries[e].hash & mask;
+			while (slots[i] != e)
+				i = (i + 1) & mask;
+			return i;
+		}
+		void add_slot(index_t e) noexcept {
+			size_t i = entries[e].hash & mask;
+			while (slots[i] != null_index)
+				i = (i + 1) & mask;
+			slots[i] = e;
+		}
+		// backward-shift deletion: later entries of the probe run move into the
+		// hole when that does not put them in front of their home slot, so the
+		// table never needs tombstones
+		void remove_slot(size_t hole) noexcept {
+			for (size_t i = (hole + 1) & mask; slots[i] != null_index; i = (i + 1) & mask) {
+				size_t home = entries[slots[i]].hash & mask;
+				if (((i - home) & mask) >= ((i - hole) & mask)) {
+					slots[hole] = slots[i];
+					hole = i;
+				}
+			}
+			slots[hole] = null_index;
+		}
+		void link_front(index_t e) noexcept {
+			entries[e].prv = null_index;
+			entries[e].ptr = head;
+			(head != null_index ? entries[head].prv : tail) = e;
+			head = e;
+		}
+		void unlink(index_t e) noexcept {
+			Entry& obj = entries[e];
+			(obj.prv != null_index ? entries[obj.prv].ptr : head) = obj.ptr;
+			(obj.ptr != null_index ? entries[obj.ptr].prv : tail) = obj.prv;
+		}
+		void touch(index_t e) noexcept {
+			if constexpr (policy == Policy::LRU) {
+				if (e != head) {
+					unlink(e);
+					link_front(e);
+				}
+			}
+			else {
+				entries[e].referenced = true;
+			}
+		}
+		// moves the entry at from into the free position to, keeping the index and
+		// the recency links pointing at it
+		void relocate(index_t from, index_t to) noexcept {
+			size_t slot = slot_of(from);
+			new (&entries[to]) Entry(std::move(entries[from]));
+			entries[from].~Entry();
+			slots[slot] = to;
+			if constexpr (policy == Policy::LRU) {
+				Entry& obj = entries[to];
+				(obj.prv != null_index ? entries[obj.prv].ptr : head) = to;
+				(obj.ptr != null_index ? entries[obj.ptr].prv : tail) = to;
+			}
+		}
+		// destroys the entry at e, which is already out of the index, and keeps the
+		// live entries packed
+		void release(index_t e) noexcept {
+			if constexpr (policy == Policy::LRU)
+				unlink(e);
+			entries[e].~Entry();
+			if (e != --length)
+				relocate(static_cast<index_t>(length), e);
+		}
+		index_t victim() noexcept {
+			if constexpr (policy == Policy::LRU) {
+				return tail;
+			}
+			else {
+				for (;; hand = (hand + 1) % length) {
+					if (!entries[hand].referenced)
+						return static_cast<index_t>(hand);
+					entries[hand].referenced = false;
+				}
+			}
+		}
+
+		value_t* get_hashed(key_t const& key, uint64_t hash) {
+			size_t slot = find_slot(key, hash);
+			if (slot == no_slot) {
+				counters.misses++;
+				return nullptr;
+			}
+			counters.hits++;
+			touch(slots[slot]);
+			return &entries[slots[slot]].value;
+		}
+		template <typename key_p, typename value_p> bool put_hashed(key_p&& key, value_p&& value, uint64_t hash) {
+			size_t slot = find_slot(key, hash);
+			if (slot != no_slot) {
+				entries[slots[slot]].value = std::forward<value_p>(value);
+				touch(slots[slot]);
+				return false;
+			}
+			if (length == capacity_v) {
+				index_t e = victim();
+				remove_slot(slot_of(e));
+				release(e);
+				counters.evictions++;
+			}
+			index_t e = static_cast<index_t>(length);
+			new (&entries[e]) Entry{ key_t(std::forward<key_p>(key)), value_t(std::forward<value_p>(value)),
+				hash, null_index, null_index, false };
+			length++;
+			add_slot(e);
+			if constexpr (policy == Policy::LRU)
+				link_front(e);
+			return true;
+		}
+		bool erase_hashed(key_t const& key, uint64_t hash) {
+			size_t slot = find_slot(key, hash);
+			if (slot == no_slot)
+				return false;
+			index_t e = slots[slot];
+			remove_slot(slot);
+			release(e);
+			return true;
+		}
+	public:
+		explicit Cache(size_t capacity) : capacity_v(capacity) {
+			if (!capacity || capacity > (size_t(1) << 30))
+				throw cache::capacity_error();
+			size_t slot_count = 2;
+			while (slot_count < capacity * 2)
+				slot_count *= 2;
+			mask = slot_count - 1;
+			size_t entry_bytes = (capacity * sizeof(Entry) + alignof(index_t) - 1) / alignof(index_t) * alignof(index_t);
+			void* slab = ::operator new(entry_bytes + slot_count * sizeof(index_t), std::align_val_t(alignof(Entry)));
+			entries = static_cast<Entry*>(slab);
+			slots = reinterpret_cast<index_t*>(static_cast<unsigned char*>(slab) + entry_bytes);
+			std::fill(slots, slots + slot_count, null_index);
+		}
+		Cache(Cache const&) = delete;
+		Cache& operator = (Cache const&) = delete;
+		~Cache() {
+			clear();
+			::operator delete(static_cast<void*>(entries), std::align_val_t(alignof(Entry)));
+		}
+
+		// looks key up and counts a hit or a miss; a hit also marks the entry as
+		// recently used. The pointer stays valid until the next put or erase.
+		value_t* get(key_t const& key) {
+			return get_hashed(key, hash_of(key));
+		}
+		// same lookup without touching the statistics or the recency order
+		value_t* peek(key_t const& key) const {
+			size_t slot = find_slot(key, hash_of(key));
+			return (slot == no_slot) ? nullptr : &entries[slots[slot]].value;
+		}
+		bool contains(key_t const& key) const {
+			return find_slot(key, hash_of(key)) != no_slot;
+		}
+		// inserts or overwrites key, evicting an entry if the cache is full;
+		// returns whether key was new
+		template <typename key_p, typename value_p> bool put(key_p&& key, value_p&& value) {
+			key_t const& ref = key;
+			return put_hashed(std::forward<key_p>(key), std::forward<value_p>(value), hash_of(ref));
+		}
+		bool erase(key_t const& key) {
+			return erase_hashed(key, hash_of(key));
+		}
+		void clear() noexcept {
+			for (size_t i = 0; i < length; i++)
+				entries[i].~Entry();
+			std::fill(slots, slots + mask + 1, null_index);
+			length = hand = 0;
+			head = tail = null_index;
+		}
+		Stats stats() const noexcept {
+			return counters;
+		}
+		void reset_stats() noexcept {
+			counters = Stats();
+		}
+		size_t size() const noexcept {
+			return length;
+		}
+		size_t capacity() const noexcept {
+			return capacity_v;
+		}
+		bool empty() const noexcept {
+			return !length;
+		}
+		// prints the entries from the most to the least recently used for LRU and
+		// in slab order for CLOCK
+		friend auto operator << (std::ostream& os, Cache const& obj) -> std::ostream& {
+			os << "{";
+			index_t e = (policy == Policy::LRU) ? obj.head : 0;
+			for (size_t i = 0; i < obj.length; i++, e = (policy == Policy::LRU) ? obj.entries[e].ptr : e + 1) {
+				os << obj.entries[e].key << ": " << obj.entries[e].value << ((i != obj.length - 1) ? ", " : "");
+			}
+			os << "}";
+			return os;
+		}
+	};
+
+	// Cache split into independently locked shards picked by the high bits of
+	// the key's hash, so threads touching different keys rarely contend. Lookups
+	// return copies because another thread may evict the entry right after.
+	template <typename key_t, typename value_t, Policy policy = Policy::LRU,
+		typename hash_t = std::hash<key_t>, typename equal_t = std::equal_to<key_t>>
+	class ShardedCache final {
+		typedef Cache<key_t, value_t, policy, hash_t, equal_t> shard_t;
+
+		struct alignas(cache_line_size) Shard {
+			std::mutex lock;
+			shard_t cache;
+
+			explicit Shard(size_t capacity) : cache(capacity) {}
+		};
+
+		Shard* shards = nullptr;
+		size_t shard_count = 1;
+		unsigned shard_bits = 0;
+		hash_t hasher;
+
+		uint64_t hash_of(key_t const& key) const {
+			return hashmap::mix_hash(static_cast<uint64_t>(hasher(key)));
+		}
+		Shard& shard_of(uint64_t hash) const noexcept {
+			return shards[(shard_bits) ? hash >> (64 - shard_bits) : 0];
+		}
+	public:
+		// capacity is split evenly over shard_count shards, rounded down to a power
+		// of two and to at most capacity
+		explicit ShardedCache(size_t capacity, size_t shard_count_p = 16) {
+			if (!capacity)
+				throw cache::capacity_error();
+			while (shard_count * 2 <= std::min(shard_count_p, capacity)) {
+				shard_count *= 2;
+				shard_bits++;
+			}
+			shards = static_cast<Shard*>(::operator new(shard_count * sizeof(Shard), std::align_val_t(alignof(Shard))));
+			size_t i = 0;
+			try {
+				for (; i < shard_count; i++)
+					new (&shards[i]) Shard((capacity + shard_count - 1) / shard_count);
+			}
+			catch (...) {
+				while (i--)
+					shards[i].~Shard();
+				::operator delete(static_cast<void*>(shards), std::align_val_t(alignof(Shard)));
+				throw;
+			}
+		}
+		ShardedCache(ShardedCache const&) = delete;
+		ShardedCache& operator = (ShardedCache const&) = delete;
+		~ShardedCache() {
+			for (size_t i = 0; i < shard_count; i++)
+				shards[i].~Shard();
+			::operator delete(static_cast<void*>(shards), std::align_val_t(alignof(Shard)));
+		}
+
+		std::optional<value_t> get(key_t const& key) {
+			uint64_t hash = hash_of(key);
+			Shard& shard = shard_of(hash);
+			std::lock_guard<std::mutex> guard(shard.lock);
+			if (value_t* value = shard.cache.get_hashed(key, hash))
+				return *value;
+			return std::nullopt;
+		}
+		bool contains(key_t const& key) const {
+			uint64_t hash = hash_of(key);
+			Shard& shard = shard_of(hash);
+			std::lock_guard<std::mutex> guard(shard.lock);
+			return shard.cache.find_slot(key, hash) != shard_t::no_slot;
+		}
+		template <typename key_p, typename value_p> bool put(key_p&& key, value_p&& value) {
+			key_t const& ref = key;
+			uint64_t hash = hash_of(ref);
+			Shard& shard = shard_of(hash);
+			std::lock_guard<std::mutex> guard(shard.lock);
+			return shard.cache.put_hashed(std::forward<key_p>(key), std::forward<value_p>(value), hash);
+		}
+		bool erase(key_t const& key) {
+			uint64_t hash = hash_of(key);
+			Shard& shard = shard_of(hash);
+			std::lock_guard<std::mutex> guard(shard.lock);
+			return shard.cache.erase_hashed(key, hash);
+		}
+		void clear() {
+			for (size_t i = 0; i < shard_count; i++) {
+				std::lock_guard<std::mutex> guard(shards[i].lock);
+				shards[i].cache.clear();
+			}
+		}
+		// the totals below lock one shard at a time, so they are not a snapshot
+		// of the whole cache while other threads keep writing
+		Stats stats() const {
+			Stats total;
+			for (size_t i = 0; i < shard_count; i++) {
+				std::lock_guard<std::mutex> guard(shards[i].lock);
+				total += shards[i].cache.stats();
+			}
+			return total;
+		}
+		size_t size() const {
+			size_t total = 0;
+			for (size_t i = 0; i < shard_count; i++) {
+				std::lock_guard<std::mutex> guard(shards[i].lock);
+				total += shards[i].cache.size();
+			}
+			return total;
+		}
+		size_t capacity() const noexcept {
+			return shard_count * shards[0].cache.capacity();
+		}
+		size_t shards_size() const noexcept {
+			return shard_count;
+		}
+	};
+}
\ No newline at end of file
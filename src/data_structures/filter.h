@@ -0,0 +1,498 @@
+﻿/*
+Copyright © 2017-2022 Yılmaz Alpaslan
+
+Permission is hereby granted, free of charge to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify,
+merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to the following
+conditions:
+
+The above copyright notice and this permission notice shall be included in all copies
+or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+PARTICULAR PURPOSE AND NOINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <iostream>
+#include <exception>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <new>
+#include <algorithm>
+#include <type_traits>
+
+#include "hashmap.h"
+
+namespace filter {
+	using queue::cache_line_size;
+
+	struct parameter_error : public std::exception {
+		virtual const char* what() const noexcept {
+			return "False-positive rate is out of range for this filter";
+		}
+	};
+	struct format_error : public std::exception {
+		virtual const char* what() const noexcept {
+			return "Buffer does not hold a serialized filter of this type";
+		}
+	};
+
+	// Serialized filters are this header followed by the filter's table, in the
+	// host's byte order. The header fills a cache line so the table stays
+	// aligned in a buffer that is, e.g. a memory-mapped file. Keys are hashed
+	// with the filter's hasher, so a buffer is only meaningful to readers that
+	// hash the same way.
+	struct Header {
+		static constexpr uint32_t magic_value = 0x52544c46;
+		static constexpr uint32_t bloom_kind = 1;
+		static constexpr uint32_t cuckoo_kind = 2;
+
+		uint32_t magic = magic_value;
+		uint32_t kind = 0;
+		uint64_t table_size = 0;
+		uint64_t count = 0;
+		uint64_t victim = 0;
+		uint32_t fingerprint_bits = 0;
+		uint32_t fingerprint_bytes = 0;
+		unsigned char padding[cache_line_size - 40] = {};
+
+		// checks that buffer holds a header of kind followed by a table of
+		// table_size units of unit bytes; the header is copied out, so buffer
+		// may have any alignment
+		static Header read(const void* buffer, size_t bytes, uint32_t kind, size_t unit) {
+			if (!buffer || bytes < sizeof(Header))
+				throw filter::format_error();
+			Header header;
+			std::memcpy(static_cast<void*>(&header), buffer, sizeof(Header));
+			if (header.magic != magic_value || header.kind != kind || !header.table_size
+				|| header.table_size > (bytes - sizeof(Header)) / unit)
+				throw filter::format_error();
+			return header;
+		}
+	};
+	static_assert(sizeof(Header) == cache_line_size);
+
+	// 512-bit Bloom filter block. A key sets one bit in each of the eight words,
+	// picked by multiplying the low half of its hash by a different odd
+	// constant, so a probe is one cache line and a fixed, branch-free loop the
+	// compiler turns into vector code.
+	struct alignas(cache_line_size) BloomBlock {
+		static constexpr size_t word_count = 8;
+
+		uint64_t words[word_count];
+
+		static void masks(uint32_t hash, uint64_t* out) noexcept {
+			constexpr uint32_t salt[word_count] = {
+				0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+				0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u
+			};
+			for (size_t i = 0; i < word_count; i++)
+				out[i] = uint64_t(1) << ((hash * salt[i]) >> 26);
+		}
+		void insert(uint32_t hash) noexcept {
+			uint64_t mask[word_count];
+			masks(hash, mask);
+			for (size_t i = 0; i < word_count; i++)
+				words[i] |= mask[i];
+		}
+		bool contains(uint32_t hash) const noexcept {
+			uint64_t mask[word_count];
+			masks(hash, mask);
+			uint64_t missing = 0;
+			for (size_t i = 0; i < word_count; i++)
+				missing |= mask[i] & ~words[i];
+			return !missing;
+		}
+		// the high half of the hash picks the block without a division
+		static size_t index(uint64_t hash, size_t count) noexcept {
+			return static_cast<size_t>(((hash >> 32) * count) >> 32);
+		}
+	};
+
+	// Read-only Bloom filter over a serialized buffer, which must be aligned to a
+	// cache line (as mapped files are) and stay unchanged while the view is used.
+	template <typename key_t, typename hash_t = hashmap::Hash<key_t>> class BloomFilterView final {
+		BloomBlock const* blocks = nullptr;
+		size_t block_count = 0;
+		hash_t hasher;
+	public:
+		BloomFilterView(const void* buffer, size_t bytes) {
+			if (reinterpret_cast<uintptr_t>(buffer) % alignof(BloomBlock))
+				throw filter::format_error();
+			Header header = Header::read(buffer, bytes, Header::bloom_kind, sizeof(BloomBlock));
+			blocks = reinterpret_cast<BloomBlock const*>(static_cast<unsigned char const*>(buffer) + sizeof(Header));
+			block_count = static_cast<size_t>(header.table_size);
+		}
+
+		bool contains(key_t const& key) const {
+			uint64_t hash = hashmap::mix_hash(static_cast<uint64_t>(hasher(key)));
+			return blocks[BloomBlock::index(hash, block_count)].contains(static_cast<uint32_t>(hash));
+		}
+	};
+
+	// Blocked Bloom filter: every key lives in a single 64-byte block, so a
+	// lookup costs one cache miss instead of one per hash function. There are
+	// no false negatives; the false-positive rate is the one asked for at the
+	// expected number of keys, and rises past it.
+	template <typename key_t, typename hash_t = hashmap::Hash<key_t>> class BloomFilter final {
+		BloomBlock* blocks = nullptr;
+		size_t block_count = 0;
+		size_t length = 0;
+		hash_t hasher;
+
+		uint64_t hash_of(key_t const& key) const {
+			return hashmap::mix_hash(static_cast<uint64_t>(hasher(key)));
+		}
+		void allocate(size_t count) {
+			blocks = static_cast<BloomBlock*>(::operator new(count * sizeof(BloomBlock), std::align_val_t(alignof(BloomBlock))));
+			block_count = count;
+			std::memset(static_cast<void*>(blocks), 0, count * sizeof(BloomBlock));
+		}
+		BloomFilter(void) = default;
+	public:
+		// sized from the standard estimate m = -k n / ln(1 - p^(1/k)) with k = 8
+		// bits per key; blocking costs a little accuracy on top of that
+		explicit BloomFilter(size_t expected, double fpp = 0.01) {
+			if (!(fpp > 0.0 && fpp < 1.0))
+				throw filter::parameter_error();
+			double k = static_cast<double>(BloomBlock::word_count);
+			double bits = -k * static_cast<double>(std::max<size_t>(expected, 1)) / std::log(1.0 - std::pow(fpp, 1.0 / k));
+			allocate(std::max<size_t>(1, static_cast<size_t>(std::ceil(bits / (sizeof(BloomBlock) * 8)))));
+		}
+		BloomFilter(BloomFilter const& obj) : length(obj.length), hasher(obj.hasher) {
+			allocate(obj.block_count);
+			std::memcpy(static_cast<void*>(blocks), obj.blocks, block_count * sizeof(BloomBlock));
+		}
+		BloomFilter(BloomFilter&& obj) noexcept {
+			swap(obj);
+		}
+		BloomFilter& operator = (BloomFilter obj) noexcept {
+			swap(obj);
+			return *this;
+		}
+		~BloomFilter() {
+			if (blocks)
+				::operator delete(static_cast<void*>(blocks), std::align_val_t(alignof(BloomBlock)));
+		}
+
+		// copies a filter out of a buffer written by serialize
+		static BloomFilter load(const void* buffer, size_t bytes) {
+			Header header = Header::read(buffer, bytes, Header::bloom_kind, sizeof(BloomBlock));
+			BloomFilter filter;
+			filter.allocate(static_cast<size_t>(header.table_size));
+			filter.length = static_cast<size_t>(header.count);
+			std::memcpy(static_cast<void*>(filter.blocks), static_cast<unsigned char const*>(buffer) + sizeof(Header),
+				static_cast<size_t>(header.table_size) * sizeof(BloomBlock));
+			return filter;
+		}
+
+		void swap(BloomFilter& obj) noexcept {
+			std::swap(blocks, obj.blocks);
+			std::swap(block_count, obj.block_count);
+			std::swap(length, obj.length);
+			std::swap(hasher, obj.hasher);
+		}
+		void insert(key_t const& key) {
+			uint64_t hash = hash_of(key);
+			blocks[BloomBlock::index(hash, block_count)].insert(static_cast<uint32_t>(hash));
+			length++;
+		}
+		bool contains(key_t const& key) const {
+			uint64_t hash = hash_of(key);
+			return blocks[BloomBlock::index(hash, block_count)].contains(static_cast<uint32_t>(hash));
+		}
+		// adds every key of obj, which must have been built with the same size
+		void merge(BloomFilter const& obj) {
+			if (obj.block_count != block_count)
+				throw filter::parameter_error();
+			for (size_t i = 0; i < block_count; i++) {
+				for (size_t j = 0; j < BloomBlock::word_count; j++)
+					blocks[i].words[j] |= obj.blocks[i].words[j];
+			}
+			length += obj.length;
+		}
+		void clear() noexcept {
+			std::memset(static_cast<void*>(blocks), 0, block_count * sizeof(BloomBlock));
+			length = 0;
+		}
+		size_t serialized_size() const noexcept {
+			return sizeof(Header) + block_count * sizeof(BloomBlock);
+		}
+		// writes serialized_size() bytes to buffer
+		void serialize(void* buffer) const {
+			Header header;
+			header.kind = Header::bloom_kind;
+			header.table_size = block_count;
+			header.count = length;
+			std::memcpy(buffer, &header, sizeof(Header));
+			std::memcpy(static_cast<unsigned char*>(buffer) + sizeof(Header), blocks, block_count * sizeof(BloomBlock));
+		}
+		// number of insert calls, duplicates included
+		size_t size() const noexcept {
+			return length;
+		}
+		size_t bytes() const noexcept {
+			return block_count * sizeof(BloomBlock);
+		}
+	};
+
+	// Cuckoo filter (Fan et al.): a cuckoo hash table of short fingerprints in
+	// buckets of four. A key's fingerprint may sit in its home bucket or in the
+	// bucket at home ^ hash(fingerprint), so both can be found from either one,
+	// which is what allows moving fingerprints around and deleting keys. The
+	// false-positive rate is about 8 / 2^bits for fingerprints of that width,
+	// and fingerprint_t must be wide enough for the rate asked for.
+	template <typename key_t, typename fingerprint_t = uint16_t, typename hash_t = hashmap::Hash<key_t>>
+	class CuckooFilter;
+
+	template <typename fingerprint_t> struct CuckooBucket {
+		static constexpr size_t slot_count = 4;
+		static constexpr uint64_t no_victim = UINT64_MAX;
+
+		fingerprint_t slots[slot_count];
+
+		bool contains(fingerprint_t fingerprint) const noexcept {
+			bool found = false;
+			for (size_t i = 0; i < slot_count; i++)
+				found |= slots[i] == fingerprint;
+			return found;
+		}
+		bool insert(fingerprint_t fingerprint) noexcept {
+			for (size_t i = 0; i < slot_count; i++) {
+				if (!slots[i]) {
+					slots[i] = fingerprint;
+					return true;
+				}
+			}
+			return false;
+		}
+		bool erase(fingerprint_t fingerprint) noexcept {
+			for (size_t i = 0; i < slot_count; i++) {
+				if (slots[i] == fingerprint) {
+					slots[i] = 0;
+					return true;
+				}
+			}
+			return false;
+		}
+		// the low bits of the hash pick the home bucket and the high ones the
+		// fingerprint, which is never 0 since 0 marks an empty slot
+		static fingerprint_t fingerprint_of(uint64_t hash, unsigned bits) noexcept {
+			uint64_t fingerprint = (hash >> 32) & ((uint64_t(1) << bits) - 1);
+			return static_cast<fingerprint_t>((fingerprint) ? fingerprint : 1);
+		}
+		static size_t alternate(size_t index, fingerprint_t fingerprint, size_t mask) noexcept {
+			return (index ^ static_cast<size_t>(hashmap::mix_hash(fingerprint))) & mask;
+		}
+		static bool lookup(CuckooBucket const* buckets, size_t mask, unsigned bits, uint64_t victim, uint64_t hash) noexcept {
+			size_t index = hash & mask;
+			fingerprint_t fingerprint = fingerprint_of(hash, bits);
+			if (buckets[index].contains(fingerprint) || buckets[alternate(index, fingerprint, mask)].contains(fingerprint))
+				return true;
+			return victim != no_victim && static_cast<fingerprint_t>(victim) == fingerprint
+				&& ((victim >> 32) == index || (victim >> 32) == alternate(index, fingerprint, mask));
+		}
+	};
+
+	// Read-only cuckoo filter over a serialized buffer, see BloomFilterView.
+	template <typename key_t, typename fingerprint_t = uint16_t, typename hash_t = hashmap::Hash<key_t>>
+	class CuckooFilterView final {
+		typedef CuckooBucket<fingerprint_t> Bucket;
+
+		Bucket const* buckets = nullptr;
+		size_t mask = 0;
+		unsigned bits = 0;
+		uint64_t victim = Bucket::no_victim;
+		hash_t hasher;
+	public:
+		CuckooFilterView(const void* buffer, size_t bytes) {
+			if (reinterpret_cast<uintptr_t>(buffer) % alignof(Bucket))
+				throw filter::format_error();
+			Header header = Header::read(buffer, bytes, Header::cuckoo_kind, sizeof(Bucket));
+			if (header.fingerprint_bytes != sizeof(fingerprint_t) || (header.table_size & (header.table_size - 1)))
+				throw filter::format_error();
+			buckets = reinterpret_cast<Bucket const*>(static_cast<unsigned char const*>(buffer) + sizeof(Header));
+			mask = static_cast<size_t>(header.table_size - 1);
+			bits = header.fingerprint_bits;
+			victim = header.victim;
+		}
+
+		bool contains(key_t const& key) const {
+			return Bucket::lookup(buckets, mask, bits, victim, hashmap::mix_hash(static_cast<uint64_t>(hasher(key))));
+		}
+	};
+
+	template <typename key_t, typename fingerprint_t, typename hash_t> class CuckooFilter final {
+		static_assert(std::is_unsigned_v<fingerprint_t>, "Fingerprints must be an unsigned integer type");
+
+		typedef CuckooBucket<fingerprint_t> Bucket;
+
+		static constexpr unsigned max_kicks = 500;
+
+		Bucket* buckets = nullptr;
+		size_t mask = 0;
+		unsigned bits = 0;
+		size_t length = 0;
+		// a fingerprint left homeless by a failed insert, kept so that insert
+		// never loses a key; while it is occupied the filter is full
+		uint64_t victim = Bucket::no_victim;
+		uint64_t random = 0x9e3779b97f4a7c15ull;
+		hash_t hasher;
+
+		uint64_t hash_of(key_t const& key) const {
+			return hashmap::mix_hash(static_cast<uint64_t>(hasher(key)));
+		}
+		void allocate(size_t count) {
+			buckets = new Bucket[count]();
+			mask = count - 1;
+		}
+		bool place(size_t index, fingerprint_t fingerprint) noexcept {
+			return buckets[index].insert(fingerprint) || buckets[Bucket::alternate(index, fingerprint, mask)].insert(fingerprint);
+		}
+		CuckooFilter(void) = default;
+	public:
+		// capacity is the number of keys to hold; buckets are kept at most ~95%
+		// full, which cuckoo filters with four slots reach reliably
+		explicit CuckooFilter(size_t capacity, double fpp = 0.001) {
+			if (!(fpp > 0.0 && fpp < 1.0))
+				throw filter::parameter_error();
+			bits = std::max(1u, static_cast<unsigned>(std::ceil(std::log2(2.0 * Bucket::slot_count / fpp))));
+			if (bits > sizeof(fingerprint_t) * 8)
+				throw filter::parameter_error();
+			size_t count = 1;
+			while (count * Bucket::slot_count * 95 < std::max<size_t>(capacity, 1) * 100)
+				count *= 2;
+			allocate(count);
+		}
+		CuckooFilter(CuckooFilter const& obj) : bits(obj.bits), length(obj.length), victim(obj.victim), hasher(obj.hasher) {
+			allocate(obj.mask + 1);
+			std::copy(obj.buckets, obj.buckets + mask + 1, buckets);
+		}
+		CuckooFilter(CuckooFilter&& obj) noexcept {
+			swap(obj);
+		}
+		CuckooFilter& operator = (CuckooFilter obj) noexcept {
+			swap(obj);
+			return *this;
+		}
+		~CuckooFilter() {
+			delete[] buckets;
+		}
+
+		// copies a filter out of a buffer written by serialize
+		static CuckooFilter load(const void* buffer, size_t bytes) {
+			Header header = Header::read(buffer, bytes, Header::cuckoo_kind, sizeof(Bucket));
+			if (header.fingerprint_bytes != sizeof(fingerprint_t) || (header.table_size & (header.table_size - 1)))
+				throw filter::format_error();
+			CuckooFilter filter;
+			filter.allocate(static_cast<size_t>(header.table_size));
+			filter.bits = header.fingerprint_bits;
+			filter.length = static_cast<size_t>(header.count);
+			filter.victim = header.victim;
+			std::memcpy(static_cast<void*>(filter.buckets), static_cast<unsigned char const*>(buffer) + sizeof(Header),
+				static_cast<size_t>(header.table_size) * sizeof(Bucket));
+			return filter;
+		}
+
+		void swap(CuckooFilter& obj) noexcept {
+			std::swap(buckets, obj.buckets);
+			std::swap(mask, obj.mask);
+			std::swap(bits, obj.bits);
+			std::swap(length, obj.length);
+			std::swap(victim, obj.victim);
+			std::swap(random, obj.random);
+			std::swap(hasher, obj.hasher);
+		}
+		// returns false if the filter is full; inserting a key twice stores two
+		// copies, each of which erase removes separately
+		bool insert(key_t const& key) {
+			if (victim != Bucket::no_victim)
+				return false;
+			uint64_t hash = hash_of(key);
+			size_t index = hash & mask;
+			fingerprint_t fingerprint = Bucket::fingerprint_of(hash, bits);
+			length++;
+			if (place(index, fingerprint))
+				return true;
+			// evict a random resident and move it to its other bucket, repeatedly
+			for (unsigned kick = 0; kick < max_kicks; kick++) {
+				random ^= random << 13;
+				random ^= random >> 7;
+				random ^= random << 17;
+				if (random & Bucket::slot_count)
+					index = Bucket::alternate(index, fingerprint, mask);
+				std::swap(fingerprint, buckets[index].slots[random % Bucket::slot_count]);
+				index = Bucket::alternate(index, fingerprint, mask);
+				if (buckets[index].insert(fingerprint))
+					return true;
+			}
+			victim = (static_cast<uint64_t>(index) << 32) | fingerprint;
+			return true;
+		}
+		bool contains(key_t const& key) const {
+			return Bucket::lookup(buckets, mask, bits, victim, hash_of(key));
+		}
+		// only erase keys that were inserted, or another key sharing the
+		// fingerprint may be removed instead
+		bool erase(key_t const& key) {
+			uint64_t hash = hash_of(key);
+			size_t index = hash & mask;
+			fingerprint_t fingerprint = Bucket::fingerprint_of(hash, bits);
+			size_t other = Bucket::alternate(index, fingerprint, mask);
+			if (victim != Bucket::no_victim && static_cast<fingerprint_t>(victim) == fingerprint
+				&& ((victim >> 32) == index || (victim >> 32) == other)) {
+				victim = Bucket::no_victim;
+			}
+			else if (!buckets[index].erase(fingerprint) && !buckets[other].erase(fingerprint)) {
+				return false;
+			}
+			length--;
+			// a slot was freed, so the homeless fingerprint may fit now
+			if (victim != Bucket::no_victim && place(static_cast<size_t>(victim >> 32), static_cast<fingerprint_t>(victim)))
+				victim = Bucket::no_victim;
+			return true;
+		}
+		void clear() noexcept {
+			std::fill(buckets, buckets + mask + 1, Bucket());
+			length = 0;
+			victim = Bucket::no_victim;
+		}
+		size_t serialized_size() const noexcept {
+			return sizeof(Header) + (mask + 1) * sizeof(Bucket);
+		}
+		// writes serialized_size() bytes to buffer
+		void serialize(void* buffer) const {
+			Header header;
+			header.kind = Header::cuckoo_kind;
+			header.table_size = mask + 1;
+			header.count = length;
+			header.victim = victim;
+			header.fingerprint_bits = bits;
+			header.fingerprint_bytes = sizeof(fingerprint_t);
+			std::memcpy(buffer, &header, sizeof(Header));
+			std::memcpy(static_cast<unsigned char*>(buffer) + sizeof(Header), buckets, (mask + 1) * sizeof(Bucket));
+		}
+		bool full() const noexcept {
+			return victim != Bucket::no_victim;
+		}
+		size_t size() const noexcept {
+			return length;
+		}
+		size_t capacity() const noexcept {
+			return (mask + 1) * Bucket::slot_count;
+		}
+		size_t bytes() const noexcept {
+			return (mask + 1) * sizeof(Bucket);
+		}
+	};
+}
\ No newline at end of file
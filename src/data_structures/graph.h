@@ -24,76 +24,62 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <iostream>
 #include <exception>
 
-#include "linkedlist.h"
+#include "array.h"
 
 #define EDGE_LIST        0x0
 #define ADJACENCY_MATRIX 0x1
 #define ADJACENCY_LIST   0x2
 
-using namespace linkedlist;
-
 namespace graph {
 	template<class T>
 	using less_than_t = decltype(std::declval<T>() < std::declval<T>());
 
 	template<class T>
-	constexpr bool has_less_than = is_detected<less_than_t, T>::value;
+	constexpr bool has_less_than = requires { typename less_than_t<T>; };
+
+	struct vertex_not_found_error : public std::exception {
+		virtual const char* what() const noexcept {
+			return "Vertex not found";
+		}
+	};
 
 	template <typename type> class Graph {
 		struct Vertex {
-			Vertex(type const& data_p, size_t index_p, size_t cost_p = 0) {
-				*data = data_p;
-				cost = cost_p;
-				index = index_p;
-			}
-			type* data = static_cast<type*>(malloc(sizeof type));
+			Vertex(type const& data_p, size_t index_p, size_t cost_p = 0) : data(data_p), index(index_p), cost(cost_p) {}
+			type data;
 			size_t degree = 0;
 			size_t index;
 			size_t cost = 0;
 		};
-		// adjacency list
-		SinglyLinkedList<SinglyLinkedList<size_t>> edges;
-		SinglyLinkedList<Vertex*> vertices;
+		// adjacency list, edges[i] holds the indices of the targets of vertex i
+		array::Vector<array::Vector<size_t>> edges;
+		// references to vertices are invalidated when create_vertex grows this
+		array::Vector<Vertex> vertices;
 	public:
 		Graph(void) = default;
 		void create_vertex(const type& data, const std::initializer_list<const Vertex*>& adj_vertices = {}, size_t cost = 0) {
-			Vertex* vertex = new Vertex(data, vertices.size(), cost);
-			vertices.push_back(vertex);
-			if (adj_vertices.size()) {
-				link(*vertex, adj_vertices);
-			}
+			size_t index = vertices.size();
+			// adj_vertices may point into vertices, so they are read before it grows
+			array::Vector<size_t>& adjacent = edges.emplace_back();
+			for (const Vertex* target : adj_vertices)
+				adjacent.push_back(target->index);
+			vertices.emplace_back(data, index, cost);
 		}
 		void link(const Vertex& vertex, const Vertex& target) {
-			try {
-				edges.at(vertex.index).push_back(target.index);
-			}
-			catch (index_error& exc) {
-				edges.push_back(SinglyLinkedList{ target.index });
-			}
+			edges[vertex.index].push_back(target.index);
 		}
 		void link(const Vertex& vertex, const std::initializer_list<const Vertex*>& targets) {
-			for (size_t i = 0; i < targets.size(); i++) {
-				try {
-					edges.at(vertex.index).push_back(targets[i]->index);
-				}
-				catch (index_error& exc) {
-					edges.push_back(SinglyLinkedList{ targets[i]->index });
-				}
-			}
+			array::Vector<size_t>& adjacent = edges[vertex.index];
+			for (const Vertex* target : targets)
+				adjacent.push_back(target->index);
 		}
+		// vertices are kept in insertion order, not sorted, so this is a scan
 		const Vertex& get_vertex(const type& data) const {
-			size_t begin = 0;
-			size_t end = vertices.size();
-			do {
-				const Vertex& mid = vertices.operator[](floor((begin + end) / 2));
-				if (*mid->data == data)
-					return mid;
-				else if (*mid->data > data)
-					begin = mid;
-				else if (*mid->data < data)
-					end = mid;
-
-			} while (1);
+			for (const Vertex& vertex : vertices) {
+				if (vertex.data == data)
+					return vertex;
+			}
+			throw vertex_not_found_error();
 		}
 	};
 }
\ No newline at end of file
@@ -0,0 +1,710 @@
+﻿/*
+Copyright © 2017-2022 Yılmaz Alpaslan
+
+Permission is hereby granted, free of charge to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify,
+merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to the following
+conditions:
+
+The above copyright notice and this permission notice shall be included in all copies
+or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+PARTICULAR PURPOSE AND NOINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <iostream>
+#include <exception>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <algorithm>
+#include <initializer_list>
+#include <tuple>
+#include <iterator>
+#include <type_traits>
+#include <new>
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <cstdint>
+
+#include "queue.h"
+
+namespace hashmap {
+	using queue::cache_line_size;
+
+	struct key_not_found_error : public std::exception {
+		virtual const char* what() const noexcept {
+			return "Specified key was not found in the map";
+		}
+	};
+
+	// spreads weak hashes such as the identity hash of integers over all bits,
+	// since tables index by the low bits
+	inline uint64_t mix_hash(uint64_t hash) noexcept {
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccdull;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+	// default hasher; the std::string one is transparent so that maps keyed by
+	// strings can be searched with string_views and literals without a copy
+	template <typename type> struct Hash : std::hash<type> {};
+	template <> struct Hash<std::string> {
+		typedef void is_transparent;
+
+		size_t operator () (std::string_view str) const noexcept {
+			return std::hash<std::string_view>()(str);
+		}
+	};
+
+	template <typename type> concept transparent = requires {
+		typename type::is_transparent;
+	};
+
+	// Open-addressing table with Robin Hood linear probing. A 16-bit word per
+	// slot holds its element's distance from the home slot plus one (0 = empty), and
+	// elements of a probe run stay sorted by home slot: an insert goes in front
+	// of the first resident that lives closer to its home and shifts the rest of
+	// the run forward, and a lookup stops at the first such slot. Erase shifts
+	// the run back instead of leaving tombstones, so lookups never slow down
+	// after deletions. With value_t = void the table is a set.
+	template <typename key_t, typename value_t, typename hash_t = Hash<key_t>, typename equal_t = std::equal_to<>>
+	class HashTable final {
+		static constexpr bool is_set = std::is_void_v<value_t>;
+		typedef std::conditional_t<is_set, key_t, std::pair<key_t, value_t>> slot_t;
+
+		static constexpr size_t npos = SIZE_MAX;
+		typedef uint16_t distance_t;
+
+		static constexpr unsigned max_distance = UINT16_MAX;
+		static constexpr size_t min_capacity = 8;
+
+		// the distance sits next to its element, so a probe touches one cache
+		// line per step instead of one in each of two arrays
+		struct Bucket {
+			distance_t dist;
+			alignas(slot_t) unsigned char storage[sizeof(slot_t)];
+
+			slot_t& slot() noexcept {
+				return *std::launder(reinterpret_cast<slot_t*>(storage));
+			}
+		};
+
+		Bucket* buckets = nullptr;
+		size_t capacity_v = 0;
+		size_t mask = 0;
+		size_t length = 0;
+		hash_t hasher;
+		equal_t equal;
+
+		// keys are converted to key_t for lookups unless both functors accept
+		// other key types
+		template <typename key_like> using lookup_t =
+			std::conditional_t<transparent<hash_t> && transparent<equal_t>, key_like, key_t>;
+
+		static key_t const& key_of(slot_t const& slot) noexcept {
+			if constexpr (is_set)
+				return slot;
+			else
+				return slot.first;
+		}
+		template <typename key_like> uint64_t hash_of(key_like const& key) const {
+			return mix_hash(static_cast<uint64_t>(hasher(key)));
+		}
+		// on a miss, leaves i and d at the slot where key belongs and the
+		// distance it would have there
+		template <typename key_like> bool probe(key_like const& key, uint64_t hash, size_t& i, unsigned& d) const {
+			i = hash & mask;
+			d = 1;
+			if (!length)
+				return false;
+			for (;; i = (i + 1) & mask, d++) {
+				if (buckets[i].dist < d)
+					return false;
+				if (buckets[i].dist == d && equal(key_of(buckets[i].slot()), key))
+					return true;
+			}
+		}
+		template <typename key_like> size_t find_index(key_like const& key) const {
+			size_t i;
+			unsigned d;
+			return probe(key, hash_of(key), i, d) ? i : npos;
+		}
+		// moves obj into slot i, shifting the run behind it; fails without
+		// touching anything if a distance would overflow distance_t
+		bool insert_at(size_t i, unsigned d, slot_t& obj) noexcept {
+			if (d > max_distance)
+				return false;
+			size_t j = i;
+			for (; buckets[j].dist; j = (j + 1) & mask) {
+				if (buckets[j].dist == max_distance)
+					return false;
+			}
+			for (; j != i; j = (j - 1) & mask) {
+				size_t prev = (j - 1) & mask;
+				new (&buckets[j].slot()) slot_t(std::move(buckets[prev].slot()));
+				buckets[prev].slot().~slot_t();
+				buckets[j].dist = buckets[prev].dist + 1;
+			}
+			new (&buckets[i].slot()) slot_t(std::move(obj));
+			buckets[i].dist = static_cast<distance_t>(d);
+			length++;
+			return true;
+		}
+		// inserts obj, whose key is known to be absent, and returns its slot
+		size_t insert_unique(slot_t& obj, uint64_t hash) {
+			for (;;) {
+				size_t i = hash & mask;
+				unsigned d = 1;
+				for (; buckets[i].dist >= d; i = (i + 1) & mask)
+					d++;
+				if (insert_at(i, d, obj))
+					return i;
+				rehash(capacity_v * 2);
+			}
+		}
+		bool needs_growth() const noexcept {
+			return (length + 1) * 5 > capacity_v * 4;
+		}
+		// the old arrays are only read while the elements move over, so an
+		// insert that overflows a distance may grow the new table recursively
+		void rehash(size_t count) {
+			Bucket* old_buckets = buckets;
+			size_t old_capacity = capacity_v;
+			allocate(count);
+			length = 0;
+			for (size_t i = 0; i < old_capacity; i++) {
+				if (old_buckets[i].dist) {
+					insert_unique(old_buckets[i].slot(), hash_of(key_of(old_buckets[i].slot())));
+					old_buckets[i].slot().~slot_t();
+				}
+			}
+			deallocate(old_buckets, old_capacity);
+		}
+		void allocate(size_t count) {
+			buckets = static_cast<Bucket*>(::operator new(count * sizeof(Bucket), std::align_val_t(alignof(Bucket))));
+			for (size_t i = 0; i < count; i++)
+				buckets[i].dist = 0;
+			capacity_v = count;
+			mask = count - 1;
+		}
+		static void deallocate(Bucket* block, size_t count) noexcept {
+			if (count)
+				::operator delete(static_cast<void*>(block), std::align_val_t(alignof(Bucket)));
+		}
+		void erase_at(size_t i) noexcept {
+			buckets[i].slot().~slot_t();
+			for (size_t next = (i + 1) & mask; buckets[next].dist > 1; i = next, next = (next + 1) & mask) {
+				new (&buckets[i].slot()) slot_t(std::move(buckets[next].slot()));
+				buckets[next].slot().~slot_t();
+				buckets[i].dist = buckets[next].dist - 1;
+			}
+			buckets[i].dist = 0;
+			length--;
+		}
+		template <typename key_p, typename... args_t> std::pair<size_t, bool> emplace_index(key_p&& key, args_t&&... args) {
+			lookup_t<std::remove_cvref_t<key_p>> const& ref = key;
+			uint64_t hash = hash_of(ref);
+			size_t i;
+			unsigned d;
+			if (probe(ref, hash, i, d))
+				return { i, false };
+			slot_t obj = make_slot(std::forward<key_p>(key), std::forward<args_t>(args)...);
+			if (needs_growth()) {
+				rehash(std::max(min_capacity, capacity_v * 2));
+				return { insert_unique(obj, hash), true };
+			}
+			if (!insert_at(i, d, obj))
+				return { insert_unique(obj, hash), true };
+			return { i, true };
+		}
+		template <typename key_p, typename... args_t> static slot_t make_slot(key_p&& key, args_t&&... args) {
+			if constexpr (is_set)
+				return slot_t(std::forward<key_p>(key), std::forward<args_t>(args)...);
+			else
+				return slot_t(std::piecewise_construct, std::forward_as_tuple(std::forward<key_p>(key)),
+					std::forward_as_tuple(std::forward<args_t>(args)...));
+		}
+	public:
+		class Iterator {
+			friend class HashTable;
+
+			HashTable const* table = nullptr;
+			size_t index = 0;
+
+			void skip() noexcept {
+				while (index < table->capacity_v && !table->buckets[index].dist)
+					index++;
+			}
+		public:
+			typedef std::forward_iterator_tag iterator_category;
+			typedef slot_t value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef slot_t* pointer;
+			typedef slot_t& reference;
+
+			Iterator(void) = default;
+			Iterator(HashTable const* table_p, size_t index_p) : table(table_p), index(index_p) {}
+
+			// keys must not be modified through an iterator
+			slot_t& operator * () const {
+				return table->buckets[index].slot();
+			}
+			slot_t* operator -> () const {
+				return &table->buckets[index].slot();
+			}
+			Iterator& operator ++ () {
+				index++;
+				skip();
+				return *this;
+			}
+			Iterator operator ++ (int) {
+				Iterator temp = *this;
+				++(*this);
+				return temp;
+			}
+			friend bool operator == (const Iterator& a, const Iterator& b) {
+				return a.index == b.index;
+			}
+			friend bool operator != (const Iterator& a, const Iterator& b) {
+				return a.index != b.index;
+			}
+		};
+
+		HashTable(void) = default;
+		explicit HashTable(size_t count) {
+			reserve(count);
+		}
+		HashTable(std::initializer_list<slot_t> const& list) {
+			reserve(list.size());
+			for (auto const& obj : list)
+				insert(obj);
+		}
+		HashTable(HashTable const& obj) : hasher(obj.hasher), equal(obj.equal) {
+			reserve(obj.length);
+			for (auto const& slot : obj)
+				insert(slot);
+		}
+		HashTable(HashTable&& obj) noexcept {
+			swap(obj);
+		}
+		HashTable& operator = (HashTable obj) noexcept {
+			swap(obj);
+			return *this;
+		}
+		~HashTable() {
+			clear();
+			deallocate(buckets, capacity_v);
+		}
+
+		void swap(HashTable& obj) noexcept {
+			std::swap(buckets, obj.buckets);
+			std::swap(capacity_v, obj.capacity_v);
+			std::swap(mask, obj.mask);
+			std::swap(length, obj.length);
+			std::swap(hasher, obj.hasher);
+			std::swap(equal, obj.equal);
+		}
+		// makes room for count elements without further rehashing
+		void reserve(size_t count) {
+			size_t target = std::max(min_capacity, capacity_v);
+			while (count * 5 > target * 4)
+				target *= 2;
+			if (target != capacity_v)
+				rehash(target);
+		}
+		// for a map, constructs the value from args unless key is already present;
+		// for a set, constructs the key from key and args
+		template <typename key_p, typename... args_t> std::pair<Iterator, bool> emplace(key_p&& key, args_t&&... args) {
+			if constexpr (is_set && sizeof...(args_t) > 0) {
+				return emplace(key_t(std::forward<key_p>(key), std::forward<args_t>(args)...));
+			}
+			else {
+				auto [i, inserted] = emplace_index(std::forward<key_p>(key), std::forward<args_t>(args)...);
+				return { Iterator(this, i), inserted };
+			}
+		}
+		std::pair<Iterator, bool> insert(slot_t const& obj) {
+			if constexpr (is_set)
+				return emplace(obj);
+			else
+				return emplace(obj.first, obj.second);
+		}
+		std::pair<Iterator, bool> insert(slot_t&& obj) {
+			if constexpr (is_set)
+				return emplace(std::move(obj));
+			else
+				return emplace(std::move(obj.first), std::move(obj.second));
+		}
+		template <typename key_p, typename value_p> std::pair<Iterator, bool> insert_or_assign(key_p&& key, value_p&& value)
+			requires (!is_set) {
+			auto [i, inserted] = emplace_index(std::forward<key_p>(key), std::forward<value_p>(value));
+			if (!inserted)
+				buckets[i].slot().second = std::forward<value_p>(value);
+			return { Iterator(this, i), inserted };
+		}
+		template <typename key_like> Iterator find(key_like const& key) const {
+			size_t i = find_index(static_cast<lookup_t<key_like> const&>(key));
+			return (i == npos) ? end() : Iterator(this, i);
+		}
+		template <typename key_like> bool contains(key_like const& key) const {
+			return find_index(static_cast<lookup_t<key_like> const&>(key)) != npos;
+		}
+		template <typename key_like> size_t count(key_like const& key) const {
+			return contains(key);
+		}
+		template <typename key_like> size_t erase(key_like const& key) {
+			size_t i = find_index(static_cast<lookup_t<key_like> const&>(key));
+			if (i == npos)
+				return 0;
+			erase_at(i);
+			return 1;
+		}
+		// returns the iterator to the element that moved into pos, if any; when a
+		// probe run wraps around the end of the table, an element from the front
+		// may move behind the iteration and be visited twice
+		Iterator erase(Iterator pos) {
+			erase_at(pos.index);
+			pos.skip();
+			return pos;
+		}
+		template <typename key_like> auto& at(key_like const& key) const requires (!is_set) {
+			size_t i = find_index(static_cast<lookup_t<key_like> const&>(key));
+			if (i == npos)
+				throw hashmap::key_not_found_error();
+			return buckets[i].slot().second;
+		}
+		template <typename key_p> auto& operator [] (key_p&& key) requires (!is_set) {
+			size_t i = emplace_index(std::forward<key_p>(key)).first;
+			return buckets[i].slot().second;
+		}
+		void clear() noexcept {
+			if constexpr (!std::is_trivially_destructible_v<slot_t>) {
+				for (size_t i = 0; i < capacity_v; i++) {
+					if (buckets[i].dist)
+						buckets[i].slot().~slot_t();
+				}
+			}
+			for (size_t i = 0; i < capacity_v; i++)
+				buckets[i].dist = 0;
+			length = 0;
+		}
+		Iterator begin() const {
+			Iterator it(this, 0);
+			it.skip();
+			return it;
+		}
+		Iterator end() const {
+			return Iterator(this, capacity_v);
+		}
+		size_t size() const noexcept {
+			return length;
+		}
+		size_t capacity() const noexcept {
+			return capacity_v;
+		}
+		bool empty() const noexcept {
+			return !length;
+		}
+		float load_factor() const noexcept {
+			return (capacity_v) ? static_cast<float>(length) / capacity_v : 0.0f;
+		}
+		friend auto operator << (std::ostream& os, HashTable const& obj) -> std::ostream& {
+			os << "{";
+			size_t i = 0;
+			for (auto const& slot : obj) {
+				if constexpr (is_set)
+					os << slot;
+				else
+					os << slot.first << ": " << slot.second;
+				os << ((++i != obj.length) ? ", " : "");
+			}
+			os << "}";
+			return os;
+		}
+	};
+
+	template <typename key_t, typename value_t, typename hash_t = Hash<key_t>, typename equal_t = std::equal_to<>>
+	using HashMap = HashTable<key_t, value_t, hash_t, equal_t>;
+	template <typename key_t, typename hash_t = Hash<key_t>, typename equal_t = std::equal_to<>>
+	using HashSet = HashTable<key_t, void, hash_t, equal_t>;
+
+	// Map for read-mostly data shared between threads. Keys are split over
+	// shards by the high bits of their hash; each shard is a linear-probing
+	// table whose writers serialize on a mutex and bump a sequence counter
+	// around every change, while readers take no lock and write nothing: they
+	// copy the entry out and retry if the sequence moved meanwhile. Entries are
+	// read while they may be changing, which is why keys and values are stored
+	// as atomics and must be trivially copyable. A shard grows by building a
+	// bigger table beside the old one and swapping the pointer, so neither
+	// readers nor other shards wait for it; old tables are only freed by
+	// reclaim() or the destructor, since a reader may still be probing them.
+	template <typename key_t, typename value_t, typename hash_t = Hash<key_t>, typename equal_t = std::equal_to<>>
+	class ConcurrentHashMap final {
+		static_assert(std::is_trivially_copyable_v<key_t> && std::is_trivially_copyable_v<value_t>,
+			"ConcurrentHashMap keys and values must be trivially copyable");
+
+		// hash == 0 marks an empty bucket; stored hashes have the top bit set
+		struct Bucket {
+			std::atomic<uint64_t> hash = 0;
+			std::atomic<key_t> key;
+			std::atomic<value_t> value;
+		};
+		struct Table {
+			Bucket* buckets;
+			size_t mask;
+			Table* retired = nullptr;
+
+			explicit Table(size_t count) : buckets(new Bucket[count]), mask(count - 1) {}
+			~Table() {
+				delete[] buckets;
+			}
+		};
+		struct alignas(cache_line_size) Shard {
+			std::atomic<uint64_t> sequence = 0;
+			std::atomic<Table*> table = nullptr;
+			std::atomic<size_t> length = 0;
+			std::mutex lock;
+			Table* retired = nullptr;
+		};
+
+		static constexpr uint64_t used_bit = uint64_t(1) << 63;
+		static constexpr size_t min_capacity = 16;
+
+		Shard* shards = nullptr;
+		size_t shard_count = 1;
+		unsigned shard_bits = 0;
+		hash_t hasher;
+		equal_t equal;
+
+		uint64_t hash_of(key_t const& key) const {
+			return mix_hash(static_cast<uint64_t>(hasher(key)));
+		}
+		Shard& shard_of(uint64_t hash) const noexcept {
+			return shards[(shard_bits) ? hash >> (64 - shard_bits) : 0];
+		}
+		// slot holding key in table, or the empty slot that ends its probe run
+		size_t find_slot(Table const* table, key_t const& key, uint64_t stored) const {
+			size_t i = stored & table->mask;
+			for (;; i = (i + 1) & table->mask) {
+				uint64_t hash = table->buckets[i].hash.load(std::memory_order_relaxed);
+				if (!hash || (hash == stored && equal(table->buckets[i].key.load(std::memory_order_relaxed), key)))
+					return i;
+			}
+		}
+		// the fence keeps the bucket stores of the change after the odd sequence
+		// number, so a reader that saw any of them also sees the counter move
+		static void write_begin(Shard& shard) noexcept {
+			shard.sequence.store(shard.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+		}
+		static void write_end(Shard& shard) noexcept {
+			shard.sequence.store(shard.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+		static void copy(Bucket& to, Bucket const& from) noexcept {
+			to.key.store(from.key.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			to.value.store(from.value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			to.hash.store(from.hash.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		}
+		// fills a new table while readers keep using the current one, then
+		// publishes it; the caller holds the shard's lock
+		void grow(Shard& shard, size_t count) {
+			Table* old_table = shard.table.load(std::memory_order_relaxed);
+			Table* table = new Table(count);
+			if (old_table) {
+				for (size_t i = 0; i <= old_table->mask; i++) {
+					Bucket const& bucket = old_table->buckets[i];
+					uint64_t hash = bucket.hash.load(std::memory_order_relaxed);
+					if (!hash)
+						continue;
+					size_t j = hash & table->mask;
+					while (table->buckets[j].hash.load(std::memory_order_relaxed))
+						j = (j + 1) & table->mask;
+					copy(table->buckets[j], bucket);
+				}
+				old_table->retired = shard.retired;
+				shard.retired = old_table;
+			}
+			shard.table.store(table, std::memory_order_release);
+		}
+		// the caller holds the shard's lock; keeps the table at most half full
+		Table* table_for_insert(Shard& shard) {
+			Table* table = shard.table.load(std::memory_order_relaxed);
+			size_t capacity = (table) ? table->mask + 1 : 0;
+			if ((shard.length.load(std::memory_order_relaxed) + 1) * 2 > capacity) {
+				grow(shard, std::max(min_capacity, capacity * 2));
+				table = shard.table.load(std::memory_order_relaxed);
+			}
+			return table;
+		}
+		bool put(key_t const& key, value_t const& value, bool assign) {
+			uint64_t hash = hash_of(key);
+			uint64_t stored = hash | used_bit;
+			Shard& shard = shard_of(hash);
+			std::lock_guard<std::mutex> guard(shard.lock);
+			Table* table = table_for_insert(shard);
+			size_t i = find_slot(table, key, stored);
+			Bucket& bucket = table->buckets[i];
+			bool inserted = !bucket.hash.load(std::memory_order_relaxed);
+			if (!inserted && !assign)
+				return false;
+			write_begin(shard);
+			bucket.value.store(value, std::memory_order_relaxed);
+			if (inserted) {
+				bucket.key.store(key, std::memory_order_relaxed);
+				bucket.hash.store(stored, std::memory_order_relaxed);
+				shard.length.fetch_add(1, std::memory_order_relaxed);
+			}
+			write_end(shard);
+			return inserted;
+		}
+	public:
+		// shard_count is rounded down to a power of two
+		explicit ConcurrentHashMap(size_t shard_count_p = 64) {
+			while (shard_count * 2 <= shard_count_p) {
+				shard_count *= 2;
+				shard_bits++;
+			}
+			shards = new Shard[shard_count];
+		}
+		ConcurrentHashMap(ConcurrentHashMap const&) = delete;
+		ConcurrentHashMap& operator = (ConcurrentHashMap const&) = delete;
+		~ConcurrentHashMap() {
+			reclaim();
+			for (size_t i = 0; i < shard_count; i++)
+				delete shards[i].table.load(std::memory_order_relaxed);
+			delete[] shards;
+		}
+
+		std::optional<value_t> get(key_t const& key) const {
+			uint64_t hash = hash_of(key);
+			uint64_t stored = hash | used_bit;
+			Shard const& shard = shard_of(hash);
+			for (;;) {
+				uint64_t sequence = shard.sequence.load(std::memory_order_acquire);
+				if (sequence & 1) {
+					std::this_thread::yield();
+					continue;
+				}
+				std::optional<value_t> result;
+				Table const* table = shard.table.load(std::memory_order_acquire);
+				// a torn read may show a run without its empty end, so the probe
+				// is also bounded by the table size
+				for (size_t i = (table) ? stored & table->mask : 0, n = 0; table && n <= table->mask; i = (i + 1) & table->mask, n++) {
+					Bucket const& bucket = table->buckets[i];
+					uint64_t found = bucket.hash.load(std::memory_order_relaxed);
+					if (!found)
+						break;
+					if (found == stored && equal(bucket.key.load(std::memory_order_relaxed), key)) {
+						result = bucket.value.load(std::memory_order_relaxed);
+						break;
+					}
+				}
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (shard.sequence.load(std::memory_order_relaxed) == sequence)
+					return result;
+			}
+		}
+		bool contains(key_t const& key) const {
+			return get(key).has_value();
+		}
+		// returns false and leaves the map unchanged if key is already present
+		bool insert(key_t const& key, value_t const& value) {
+			return put(key, value, false);
+		}
+		// returns whether key was new
+		bool insert_or_assign(key_t const& key, value_t const& value) {
+			return put(key, value, true);
+		}
+		bool erase(key_t const& key) {
+			uint64_t hash = hash_of(key);
+			uint64_t stored = hash | used_bit;
+			Shard& shard = shard_of(hash);
+			std::lock_guard<std::mutex> guard(shard.lock);
+			Table* table = shard.table.load(std::memory_order_relaxed);
+			if (!table)
+				return false;
+			size_t hole = find_slot(table, key, stored);
+			if (!table->buckets[hole].hash.load(std::memory_order_relaxed))
+				return false;
+			write_begin(shard);
+			// backward-shift deletion, as in cache::Cache
+			for (size_t i = (hole + 1) & table->mask;; i = (i + 1) & table->mask) {
+				uint64_t next = table->buckets[i].hash.load(std::memory_order_relaxed);
+				if (!next)
+					break;
+				size_t home = next & table->mask;
+				if (((i - home) & table->mask) >= ((i - hole) & table->mask)) {
+					copy(table->buckets[hole], table->buckets[i]);
+					hole = i;
+				}
+			}
+			table->buckets[hole].hash.store(0, std::memory_order_relaxed);
+			shard.length.fetch_sub(1, std::memory_order_relaxed);
+			write_end(shard);
+			return true;
+		}
+		// makes room for count elements spread evenly over the shards
+		void reserve(size_t count) {
+			size_t target = min_capacity;
+			while (target < (count + shard_count - 1) / shard_count * 2)
+				target *= 2;
+			for (size_t i = 0; i < shard_count; i++) {
+				std::lock_guard<std::mutex> guard(shards[i].lock);
+				Table* table = shards[i].table.load(std::memory_order_relaxed);
+				if (!table || table->mask + 1 < target)
+					grow(shards[i], target);
+			}
+		}
+		void clear() {
+			for (size_t i = 0; i < shard_count; i++) {
+				std::lock_guard<std::mutex> guard(shards[i].lock);
+				Table* table = shards[i].table.load(std::memory_order_relaxed);
+				if (!table)
+					continue;
+				write_begin(shards[i]);
+				for (size_t j = 0; j <= table->mask; j++)
+					table->buckets[j].hash.store(0, std::memory_order_relaxed);
+				shards[i].length.store(0, std::memory_order_relaxed);
+				write_end(shards[i]);
+			}
+		}
+		// frees the tables replaced by growth; only call while no other thread is
+		// using the map
+		void reclaim() noexcept {
+			for (size_t i = 0; i < shard_count; i++) {
+				while (Table* table = shards[i].retired) {
+					shards[i].retired = table->retired;
+					delete table;
+				}
+			}
+		}
+		// sums the shards one at a time, so it is only exact while no writer runs
+		size_t size() const noexcept {
+			size_t total = 0;
+			for (size_t i = 0; i < shard_count; i++)
+				total += shards[i].length.load(std::memory_order_relaxed);
+			return total;
+		}
+		bool empty() const noexcept {
+			return !size();
+		}
+		size_t shards_size() const noexcept {
+			return shard_count;
+		}
+	};
+}
\ No newline at end of file
@@ -23,6 +23,14 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <iostream>
 #include <exception>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+#include "threadpool.h"
 
 namespace linkedlist {
 	typedef size_t index_t;
@@ -43,6 +51,83 @@ namespace linkedlist {
 		}
 	};
 
+	// Merge sort over a null-terminated chain of nodes linked through ptr, shared
+	// by the list classes. Nodes are relinked in place, never copied or
+	// allocated, and equal elements keep their order.
+	template <typename node_t, typename compare> node_t* merge_chains(node_t* a, node_t* b, compare& comp) {
+		node_t* head = nullptr;
+		node_t** tail = &head;
+		while (a && b) {
+			if (comp(*b->data, *a->data)) {
+				*tail = b;
+				b = b->ptr;
+			}
+			else {
+				*tail = a;
+				a = a->ptr;
+			}
+			tail = &(*tail)->ptr;
+		}
+		*tail = (a) ? a : b;
+		return head;
+	}
+	// bottom-up: runs[i] holds a sorted run of 2^i nodes, and each new node is
+	// carried upwards like a binary counter, so there is no recursion and no
+	// need to know the length in advance
+	template <typename node_t, typename compare> node_t* sort_chain(node_t* head, compare& comp) {
+		node_t* runs[sizeof(size_t) * 8] = {};
+		size_t top = 0;
+		while (head) {
+			node_t* run = head;
+			head = head->ptr;
+			run->ptr = nullptr;
+			size_t i = 0;
+			for (; runs[i]; i++) {
+				run = merge_chains(runs[i], run, comp);
+				runs[i] = nullptr;
+			}
+			runs[i] = run;
+			top = std::max(top, i + 1);
+		}
+		node_t* result = nullptr;
+		for (size_t i = 0; i < top; i++) {
+			if (runs[i])
+				result = merge_chains(runs[i], result, comp);
+		}
+		return result;
+	}
+	// cuts the chain into one piece per pool slot, sorts the pieces as separate
+	// tasks and then merges neighbouring pieces pairwise, also in parallel
+	template <typename node_t, typename compare>
+	node_t* parallel_sort_chain(node_t* head, size_t length, compare& comp, threadpool::ThreadPool& pool) {
+		constexpr size_t max_pieces = 64, min_piece = 4096;
+		size_t pieces = std::min({ max_pieces, pool.size() * 2, length / min_piece });
+		if (pieces < 2)
+			return sort_chain(head, comp);
+		node_t* piece[max_pieces];
+		size_t step = length / pieces;
+		for (size_t i = 0; i < pieces; i++) {
+			piece[i] = head;
+			if (i == pieces - 1)
+				break;
+			for (size_t j = 1; j < step; j++)
+				head = head->ptr;
+			node_t* next = head->ptr;
+			head->ptr = nullptr;
+			head = next;
+		}
+		threadpool::TaskGroup group(pool);
+		for (size_t i = 0; i < pieces; i++)
+			group.run([&piece, &comp, i] { piece[i] = sort_chain(piece[i], comp); });
+		group.wait();
+		for (size_t width = 1; width < pieces; width *= 2) {
+			for (size_t i = 0; i + width < pieces; i += width * 2)
+				group.run([&piece, &comp, i, width] { piece[i] = merge_chains(piece[i], piece[i + width], comp); });
+			group.wait();
+		}
+		return piece[0];
+	}
+
 	template <typename type> class SinglyLinkedList final {
 		struct Node {
 			Node(type const& data, Node* ptr) {
@@ -62,6 +147,8 @@ namespace linkedlist {
 			Node* ptr;
 		};
 		class Iterator {
+			friend class SinglyLinkedList;
+
 			Node* addr = nullptr;
 		public:
 			Iterator(Node* ptr) : addr(ptr) {}
@@ -89,6 +176,58 @@ namespace linkedlist {
 		Node* base_addr = nullptr;
 		Node* last_addr = nullptr;
 		size_t length = 0;
+		// node found by the last indexed lookup; lookups at or after it resume
+		// from there, so walking the list by increasing index is O(1) per step.
+		// Only non-const members move it, so const access stays free of writes
+		// and concurrent readers of a const list do not race.
+		Node* cursor_addr = nullptr;
+		index_t cursor_index = 0;
+
+		// walks from base_addr without looking at the cursor
+		Node* find_node(index_t index) const {
+			if (index >= length)
+				throw linkedlist::index_error();
+			if (index == length - 1)
+				return last_addr;
+			Node* addr = base_addr;
+			for (index_t i = 0; i < index; i++)
+				addr = addr->ptr;
+			return addr;
+		}
+		Node* node_at(index_t index) {
+			if (index >= length)
+				throw linkedlist::index_error();
+			if (index == length - 1)
+				return last_addr;
+			Node* addr = base_addr;
+			index_t i = 0;
+			if (cursor_addr && cursor_index <= index) {
+				addr = cursor_addr;
+				i = cursor_index;
+			}
+			for (; i < index; i++)
+				addr = addr->ptr;
+			cursor_addr = addr;
+			cursor_index = index;
+			return addr;
+		}
+		// forgets the cursor if the nodes from index onwards are about to move
+		void invalidate(index_t index) noexcept {
+			if (cursor_index >= index)
+				cursor_addr = nullptr;
+		}
+		// finds last_addr again after the chain was rebuilt from base_addr
+		void relink() noexcept {
+			cursor_addr = nullptr;
+			last_addr = base_addr;
+			while (last_addr && last_addr->ptr)
+				last_addr = last_addr->ptr;
+		}
+		// forgets the nodes without freeing them, after they were moved elsewhere
+		void detach() noexcept {
+			base_addr = last_addr = cursor_addr = nullptr;
+			length = 0;
+		}
 	public:
 		SinglyLinkedList(void) = default;
 		SinglyLinkedList(std::initializer_list<type> const& list) {
@@ -96,67 +235,55 @@ namespace linkedlist {
 				push_back(obj);
 			}
 		}
+		SinglyLinkedList(SinglyLinkedList const& obj) {
+			for (Node* addr = obj.base_addr; addr; addr = addr->ptr)
+				push_back(*addr->data);
+		}
+		SinglyLinkedList(SinglyLinkedList&& obj) noexcept : base_addr(obj.base_addr), last_addr(obj.last_addr), length(obj.length) {
+			obj.detach();
+		}
 		~SinglyLinkedList() {
-			for (Node* next = nullptr, *addr = base_addr; addr; (next == addr) ? (addr = next) : (addr = nullptr)) {
-				if (addr->ptr)
-					next = addr->ptr;
-				delete addr;
-			}
+			clear();
 		}
 
 		Node* insert(type const& obj, index_t index) {
-			if (!base_addr) {
-				base_addr = new Node(obj, nullptr);
-				last_addr = base_addr;
-				length++;
-				return base_addr;
-			}
+			if (index > length)
+				index = length;
+			invalidate(index);
 			Node* addr = nullptr;
-			switch (index) {
-			case 0:
+			if (!index) {
 				addr = new Node(obj, base_addr);
 				base_addr = addr;
-				length++;
-				return addr;
-			default:
-				if (index >= length) {
-					addr = new Node(obj, nullptr);
-					last_addr->ptr = addr;
+				if (!last_addr)
 					last_addr = addr;
-					length++;
-					return addr;
-				}
-				Node* curr = this->base_addr;
-				for (index_t i = 0; curr && i < index; curr = curr->ptr, i++) {
-					if (i == index - 1) {
-						addr = new Node(obj, curr->ptr);
-						curr->ptr = addr;
-					}
-				}
-				length++;
-				return addr;
 			}
+			else if (index == length) {
+				addr = new Node(obj, nullptr);
+				last_addr->ptr = addr;
+				last_addr = addr;
+			}
+			else {
+				Node* prev = node_at(index - 1);
+				addr = new Node(obj, prev->ptr);
+				prev->ptr = addr;
+			}
+			length++;
+			return addr;
 		}
 		Node* push_back(type const& obj) {
 			return this->insert(obj, length);
 		}
 		void erase(index_t const index) {
-			Node* next = base_addr->ptr;
-			Node* curr = base_addr;
-			Node* prev = nullptr;
-			for (index_t i = 0; i <= index; i++) {
-				if (i == index) {
-					delete curr;
-					if (prev)
-						prev->ptr = next;
-					else
-						base_addr = next;
-					return;
-				}
-				prev = curr;
-				curr = curr->ptr;
-				next = next->ptr;
-			}
+			if (index >= length)
+				throw linkedlist::index_error();
+			invalidate(index);
+			Node* prev = (index) ? node_at(index - 1) : nullptr;
+			Node* node = (prev) ? prev->ptr : base_addr;
+			(prev ? prev->ptr : base_addr) = node->ptr;
+			if (node == last_addr)
+				last_addr = prev;
+			delete node;
+			length--;
 		}
 		void remove(type const& obj) {
 			erase(index(obj));
@@ -167,15 +294,101 @@ namespace linkedlist {
 		Iterator end() {
 			return Iterator((last_addr) ? last_addr->ptr : last_addr);
 		}
-		void merge(SinglyLinkedList<type> const& list) noexcept {
-			Node* addr = list.base_addr;
-			for (size_t i = 0, j = 0; j < list.size(); i += 2, j++, addr = addr->ptr) {
-				insert(*addr->data, i + 1);
+		// interleaves copies of list's elements with this list's, one after each
+		// element, and appends whatever is left of list at the end
+		void merge(SinglyLinkedList<type> const& list) {
+			cursor_addr = nullptr;
+			Node* addr = base_addr;
+			for (Node* src = list.base_addr; src; src = src->ptr) {
+				if (!addr) {
+					push_back(*src->data);
+					continue;
+				}
+				Node* node = new Node(*src->data, addr->ptr);
+				addr->ptr = node;
+				if (addr == last_addr)
+					last_addr = node;
+				addr = node->ptr;
+				length++;
 			}
 		}
+		// same as above, but relinks list's nodes instead of copying them
+		void merge(SinglyLinkedList<type>&& list) noexcept {
+			if (&list == this)
+				return;
+			cursor_addr = nullptr;
+			Node* addr = base_addr;
+			Node* src = list.base_addr;
+			for (; src && addr; addr = addr->ptr) {
+				Node* next = src->ptr;
+				src->ptr = addr->ptr;
+				addr->ptr = src;
+				if (addr == last_addr)
+					last_addr = src;
+				addr = src;
+				src = next;
+			}
+			if (src) {
+				(last_addr ? last_addr->ptr : base_addr) = src;
+				last_addr = list.last_addr;
+			}
+			length += list.length;
+			list.detach();
+		}
+		// moves every node of list after pos, which must refer to an element, in O(1)
+		void splice_after(Iterator pos, SinglyLinkedList<type>&& list) {
+			if (!pos.addr)
+				throw linkedlist::index_error();
+			if (list.empty() || &list == this)
+				return;
+			list.last_addr->ptr = pos.addr->ptr;
+			pos.addr->ptr = list.base_addr;
+			if (pos.addr == last_addr)
+				last_addr = list.last_addr;
+			length += list.length;
+			cursor_addr = nullptr;
+			list.detach();
+		}
+		// moves every node of list in front of pos; O(1) at begin() and end(),
+		// elsewhere the predecessor of pos has to be found first
+		void splice(Iterator pos, SinglyLinkedList<type>&& list) {
+			if (list.empty() || &list == this)
+				return;
+			if (!pos.addr)
+				return append(std::move(list));
+			if (pos.addr != base_addr) {
+				Node* prev = base_addr;
+				while (prev->ptr != pos.addr)
+					prev = prev->ptr;
+				return splice_after(Iterator(prev), std::move(list));
+			}
+			list.last_addr->ptr = base_addr;
+			base_addr = list.base_addr;
+			length += list.length;
+			cursor_addr = nullptr;
+			list.detach();
+		}
+		void append(SinglyLinkedList<type>&& list) noexcept {
+			if (list.empty() || &list == this)
+				return;
+			(last_addr ? last_addr->ptr : base_addr) = list.base_addr;
+			last_addr = list.last_addr;
+			length += list.length;
+			list.detach();
+		}
+		void clear() noexcept {
+			for (Node* addr = base_addr; addr;) {
+				Node* next = addr->ptr;
+				delete addr;
+				addr = next;
+			}
+			detach();
+		}
 		void reverse() {
 			if (!base_addr)
 				throw linkedlist::list_empty_error();
+			cursor_addr = nullptr;
+			last_addr = base_addr;
 			Node* prev = nullptr;
 			Node* addr = base_addr;
 			Node* next = base_addr->ptr;
@@ -186,6 +399,18 @@ namespace linkedlist {
 			}
 			base_addr = prev;
 		}
+		// stable O(n log n) merge sort that relinks the existing nodes
+		template <typename compare = std::less<type>> void sort(compare comp = compare()) {
+			base_addr = linkedlist::sort_chain(base_addr, comp);
+			relink();
+		}
+		// same as sort, but sorts pieces of the list on pool's threads before
+		// merging them; comp must be safe to call concurrently
+		template <typename compare = std::less<type>>
+		void parallel_sort(compare comp = compare(), threadpool::ThreadPool& pool = threadpool::default_pool()) {
+			base_addr = linkedlist::parallel_sort_chain(base_addr, length, comp, pool);
+			relink();
+		}
 		bool has(type const& obj) {
 			try {
 				index(obj);
@@ -203,6 +428,9 @@ namespace linkedlist {
 			}
 			throw linkedlist::element_not_found_error();
 		}
+		type& at(const size_t index) {
+			return (*this)[index];
+		}
 		type& at(const size_t index) const {
 			return (*this)[index];
 		}
@@ -213,21 +441,44 @@ namespace linkedlist {
 			return !length;
 		}
 		type& operator [] (index_t index) {
-			index_t i = 0;
-			for (Node* addr = this->base_addr; addr; addr = addr->ptr, i++)
-				if (i == index)
-					return *addr->data;
-			throw linkedlist::index_error();
+			return *node_at(index)->data;
 		}
+		type& operator [] (index_t index) const {
+			return *find_node(index)->data;
+		}
+		// reuses the nodes already allocated, then appends or frees the difference
 		SinglyLinkedList& operator = (SinglyLinkedList const& obj) {
-			for (size_t i = 0; i < obj.size(); i++) {
-				try {
-					operator[](i) = obj[i];
-				}
-				catch (linkedlist::index_error& exc) {
-					insert(obj[i]);
+			if (this == &obj)
+				return *this;
+			cursor_addr = nullptr;
+			Node* prev = nullptr;
+			Node* addr = base_addr;
+			Node* src = obj.base_addr;
+			for (; addr && src; prev = addr, addr = addr->ptr, src = src->ptr)
+				*addr->data = *src->data;
+			if (addr) {
+				(prev ? prev->ptr : base_addr) = nullptr;
+				last_addr = prev;
+				length = obj.length;
+				while (addr) {
+					Node* next = addr->ptr;
+					delete addr;
+					addr = next;
 				}
 			}
+			for (; src; src = src->ptr)
+				push_back(*src->data);
+			return *this;
+		}
+		SinglyLinkedList& operator = (SinglyLinkedList&& obj) noexcept {
+			if (this != &obj) {
+				clear();
+				base_addr = obj.base_addr;
+				last_addr = obj.last_addr;
+				length = obj.length;
+				obj.detach();
+			}
+			return *this;
 		}
 		friend auto operator << (std::ostream& os, SinglyLinkedList const& obj) -> std::ostream& {
 			os << "[";
@@ -259,14 +510,30 @@ namespace linkedlist {
 			Node* ptr;
 			Node* prv;
 		};
+	public:
+		// end() holds a null node, so the iterator also keeps the list to step
+		// back from it to last_addr
 		class Iterator {
+			friend class DoublyLinkedList;
+
 			Node* addr = nullptr;
+			const DoublyLinkedList* list = nullptr;
 		public:
-			Iterator(Node* ptr) : addr(ptr) {}
+			typedef std::bidirectional_iterator_tag iterator_category;
+			typedef type value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef type* pointer;
+			typedef type& reference;
+
+			Iterator(void) = default;
+			Iterator(Node* ptr, const DoublyLinkedList* list_p) : addr(ptr), list(list_p) {}
 
 			type& operator * () const {
 				return *addr->data;
 			}
+			type* operator -> () const {
+				return addr->data;
+			}
 			Iterator& operator ++ () {
 				addr = addr->ptr;
 				return *this;
@@ -276,6 +543,15 @@ namespace linkedlist {
 				++(*this);
 				return temp;
 			}
+			Iterator& operator -- () {
+				addr = (addr) ? addr->prv : list->last_addr;
+				return *this;
+			}
+			Iterator operator -- (int) {
+				Iterator temp = *this;
+				--(*this);
+				return temp;
+			}
 			friend bool operator == (const Iterator& a, const Iterator& b) {
 				return a.addr == b.addr;
 			}
@@ -283,10 +559,84 @@ namespace linkedlist {
 				return a.addr != b.addr;
 			}
 		};
-
+		typedef std::reverse_iterator<Iterator> ReverseIterator;
+	private:
 		Node* base_addr = nullptr;
 		Node* last_addr = nullptr;
 		size_t length = 0;
+		// node found by the last indexed lookup, see SinglyLinkedList
+		Node* cursor_addr = nullptr;
+		index_t cursor_index = 0;
+
+		// walks from whichever end is closer, without looking at the cursor
+		Node* find_node(index_t index) const {
+			if (index >= length)
+				throw linkedlist::index_error();
+			Node* addr = base_addr;
+			if (length - 1 - index < index) {
+				addr = last_addr;
+				for (index_t i = length - 1; i > index; i--)
+					addr = addr->prv;
+				return addr;
+			}
+			for (index_t i = 0; i < index; i++)
+				addr = addr->ptr;
+			return addr;
+		}
+		// starts from whichever of base_addr, last_addr and the cursor is closest
+		Node* node_at(index_t index) {
+			if (index >= length)
+				throw linkedlist::index_error();
+			Node* addr = base_addr;
+			index_t i = 0;
+			if (length - 1 - index < index) {
+				addr = last_addr;
+				i = length - 1;
+			}
+			index_t distance = (i > index) ? i - index : index - i;
+			if (cursor_addr && ((cursor_index > index) ? cursor_index - index : index - cursor_index) < distance) {
+				addr = cursor_addr;
+				i = cursor_index;
+			}
+			for (; i < index; i++)
+				addr = addr->ptr;
+			for (; i > index; i--)
+				addr = addr->prv;
+			cursor_addr = addr;
+			cursor_index = index;
+			return addr;
+		}
+		void invalidate(index_t index) noexcept {
+			if (cursor_index >= index)
+				cursor_addr = nullptr;
+		}
+		// restores prv and last_addr after the chain was rebuilt through ptr only
+		void relink() noexcept {
+			cursor_addr = nullptr;
+			last_addr = nullptr;
+			for (Node* addr = base_addr; addr; addr = addr->ptr) {
+				addr->prv = last_addr;
+				last_addr = addr;
+			}
+		}
+		void detach() noexcept {
+			base_addr = last_addr = cursor_addr = nullptr;
+			length = 0;
+		}
+		Node* link_before(Node* next, type const& obj) {
+			Node* prev = (next) ? next->prv : last_addr;
+			Node* addr = new Node(obj, next, prev);
+			(prev ? prev->ptr : base_addr) = addr;
+			(next ? next->prv : last_addr) = addr;
+			length++;
+			return addr;
+		}
+		void unlink(Node* node) noexcept {
+			(node->prv ? node->prv->ptr : base_addr) = node->ptr;
+			(node->ptr ? node->ptr->prv : last_addr) = node->prv;
+			delete node;
+			length--;
+		}
 	public:
 		DoublyLinkedList(void) = default;
 		DoublyLinkedList(std::initializer_list<type> const& list) {
@@ -294,94 +644,188 @@ namespace linkedlist {
 				push_back(obj);
 			}
 		}
+		DoublyLinkedList(DoublyLinkedList const& obj) {
+			for (Node* addr = obj.base_addr; addr; addr = addr->ptr)
+				push_back(*addr->data);
+		}
+		DoublyLinkedList(DoublyLinkedList&& obj) noexcept : base_addr(obj.base_addr), last_addr(obj.last_addr), length(obj.length) {
+			obj.detach();
+		}
 		~DoublyLinkedList() {
-			for (Node* next = nullptr, addr = base_addr; addr; (next == addr) ? (addr = next) : (addr = nullptr)) {
-				if (addr->ptr)
-					next = addr->ptr;
-				delete addr;
-			}
+			clear();
 		}
 
 		Node* insert(type const& obj, index_t index) {
-			if (!base_addr) {
-				base_addr = new Node(obj, nullptr, nullptr);
-				last_addr = base_addr;
-				length++;
-				return base_addr;
-			}
-			Node* addr = nullptr;
-			switch (index) {
-			case 0:
-				addr = new Node(obj, base_addr, nullptr);
-				base_addr = addr;
-				length++;
-				return addr;
-			default:
-				if (index >= length) {
-					addr = new Node(obj, nullptr, last_addr);
-					last_addr->ptr = addr;
-					last_addr = addr;
-					length++;
-					return addr;
-				}
-				Node* curr = this->base_addr;
-				for (index_t i = 0; curr && i < index; curr = curr->ptr, i++) {
-					if (i == index - 1) {
-						length++;
-						return curr->ptr = new Node(obj, curr->ptr, curr->prv);
-					}
-				}
-			}
+			if (index > length)
+				index = length;
+			Node* next = (index < length) ? node_at(index) : nullptr;
+			invalidate(index);
+			return link_before(next, obj);
+		}
+		// O(1) positional operations; the indexing cursor is dropped because the
+		// index of pos is not known
+		Iterator insert(Iterator pos, type const& obj) {
+			cursor_addr = nullptr;
+			return Iterator(link_before(pos.addr, obj), this);
+		}
+		Iterator erase(Iterator pos) {
+			if (!pos.addr)
+				throw linkedlist::index_error();
+			Node* next = pos.addr->ptr;
+			cursor_addr = nullptr;
+			unlink(pos.addr);
+			return Iterator(next, this);
 		}
 		Node* push_back(type const& obj) {
-			return this->insert(obj, length);
+			return link_before(nullptr, obj);
+		}
+		Node* push_front(type const& obj) {
+			cursor_index++;
+			return link_before(base_addr, obj);
+		}
+		void pop_back() {
+			if (!length)
+				throw linkedlist::list_empty_error();
+			if (cursor_addr == last_addr)
+				cursor_addr = nullptr;
+			unlink(last_addr);
+		}
+		void pop_front() {
+			if (!length)
+				throw linkedlist::list_empty_error();
+			if (cursor_addr == base_addr)
+				cursor_addr = nullptr;
+			else
+				cursor_index--;
+			unlink(base_addr);
 		}
 		void erase(index_t const index) {
-			Node* next = base_addr->ptr;
-			Node* curr = base_addr;
-			Node* prev = nullptr;
-			for (index_t i = 0; i <= index; i++) {
-				if (i == index) {
-					delete curr;
-					if (prev)
-						prev->ptr = next;
-					else
-						base_addr = next;
-					return;
-				}
-				prev = curr;
-				curr = curr->ptr;
-				next = next->ptr;
-			}
+			Node* node = node_at(index);
+			invalidate(index);
+			unlink(node);
 		}
 		void remove(type const& obj) {
 			erase(index(obj));
 		}
-		Iterator begin() {
-			return Iterator(base_addr);
+		type& front() const {
+			if (!length)
+				throw linkedlist::list_empty_error();
+			return *base_addr->data;
 		}
-		Iterator end() {
-			return Iterator((last_addr) ? last_addr->ptr : last_addr);
+		type& back() const {
+			if (!length)
+				throw linkedlist::list_empty_error();
+			return *last_addr->data;
+		}
+		Iterator begin() const {
+			return Iterator(base_addr, this);
+		}
+		Iterator end() const {
+			return Iterator(nullptr, this);
+		}
+		ReverseIterator rbegin() const {
+			return ReverseIterator(end());
 		}
-		void merge(DoublyLinkedList<type> const& list) noexcept {
-			Node* addr = list.base_addr;
-			for (size_t i = 0, j = 0; j < list.size(); i += 2, j++, addr = addr->ptr) {
-				insert(*addr->data, i + 1);
+		ReverseIterator rend() const {
+			return ReverseIterator(begin());
+		}
+		// see SinglyLinkedList::merge
+		void merge(DoublyLinkedList<type> const& list) {
+			cursor_addr = nullptr;
+			Node* addr = base_addr;
+			for (Node* src = list.base_addr; src; src = src->ptr) {
+				if (!addr) {
+					push_back(*src->data);
+					continue;
+				}
+				Node* node = new Node(*src->data, addr->ptr, addr);
+				(addr->ptr ? addr->ptr->prv : last_addr) = node;
+				addr->ptr = node;
+				addr = node->ptr;
+				length++;
+			}
+		}
+		void merge(DoublyLinkedList<type>&& list) noexcept {
+			if (&list == this)
+				return;
+			cursor_addr = nullptr;
+			Node* addr = base_addr;
+			Node* src = list.base_addr;
+			for (; src && addr; addr = addr->ptr) {
+				Node* next = src->ptr;
+				src->ptr = addr->ptr;
+				src->prv = addr;
+				(addr->ptr ? addr->ptr->prv : last_addr) = src;
+				addr->ptr = src;
+				addr = src;
+				src = next;
+			}
+			if (src) {
+				src->prv = last_addr;
+				(last_addr ? last_addr->ptr : base_addr) = src;
+				last_addr = list.last_addr;
+			}
+			length += list.length;
+			list.detach();
+		}
+		// moves every node of list in front of pos in O(1)
+		void splice(Iterator pos, DoublyLinkedList<type>&& list) noexcept {
+			if (list.empty() || &list == this)
+				return;
+			Node* next = pos.addr;
+			Node* prev = (next) ? next->prv : last_addr;
+			list.base_addr->prv = prev;
+			list.last_addr->ptr = next;
+			(prev ? prev->ptr : base_addr) = list.base_addr;
+			(next ? next->prv : last_addr) = list.last_addr;
+			length += list.length;
+			cursor_addr = nullptr;
+			list.detach();
+		}
+		// moves every node of list after pos, which must refer to an element
+		void splice_after(Iterator pos, DoublyLinkedList<type>&& list) {
+			if (!pos.addr)
+				throw linkedlist::index_error();
+			splice(Iterator(pos.addr->ptr, this), std::move(list));
+		}
+		void append(DoublyLinkedList<type>&& list) noexcept {
+			splice(end(), std::move(list));
+		}
+		void clear() noexcept {
+			for (Node* addr = base_addr; addr;) {
+				Node* next = addr->ptr;
+				delete addr;
+				addr = next;
 			}
+			detach();
 		}
 		void reverse() {
 			if (!base_addr)
 				throw linkedlist::list_empty_error();
+			cursor_addr = nullptr;
+			last_addr = base_addr;
 			Node* prev = nullptr;
 			Node* addr = base_addr;
 			Node* next = base_addr->ptr;
 			for (index_t i = 0; addr; i++, addr = next) {
 				next = addr->ptr;
 				addr->ptr = prev;
+				addr->prv = next;
 				prev = addr;
 			}
 			base_addr = prev;
 		}
+		// stable O(n log n) merge sort that relinks the existing nodes
+		template <typename compare = std::less<type>> void sort(compare comp = compare()) {
+			base_addr = linkedlist::sort_chain(base_addr, comp);
+			relink();
+		}
+		// see SinglyLinkedList::parallel_sort
+		template <typename compare = std::less<type>>
+		void parallel_sort(compare comp = compare(), threadpool::ThreadPool& pool = threadpool::default_pool()) {
+			base_addr = linkedlist::parallel_sort_chain(base_addr, length, comp, pool);
+			relink();
+		}
 		bool has(type const& obj) {
 			try {
 				index(obj);
@@ -399,6 +843,9 @@ namespace linkedlist {
 			}
 			throw linkedlist::element_not_found_error();
 		}
+		type& at(index_t const index) {
+			return (*this)[index];
+		}
 		type& at(index_t const index) const {
 			return (*this)[index];
 		}
@@ -409,21 +856,44 @@ namespace linkedlist {
 			return !length;
 		}
 		type& operator [] (index_t index) {
-			index_t i = 0;
-			for (Node* addr = this->base_addr; addr; addr = addr->ptr, i++)
-				if (i == index)
-					return *addr->data;
-			throw linkedlist::index_error();
+			return *node_at(index)->data;
+		}
+		type& operator [] (index_t index) const {
+			return *find_node(index)->data;
 		}
+		// reuses the nodes already allocated, then appends or frees the difference
 		DoublyLinkedList& operator = (DoublyLinkedList const& obj) {
-			for (size_t i = 0; i < obj.size(); i++) {
-				try {
-					operator[](i) = obj[i];
-				}
-				catch (linkedlist::index_error& exc) {
-					insert(obj[i]);
+			if (this == &obj)
+				return *this;
+			cursor_addr = nullptr;
+			Node* prev = nullptr;
+			Node* addr = base_addr;
+			Node* src = obj.base_addr;
+			for (; addr && src; prev = addr, addr = addr->ptr, src = src->ptr)
+				*addr->data = *src->data;
+			if (addr) {
+				(prev ? prev->ptr : base_addr) = nullptr;
+				last_addr = prev;
+				length = obj.length;
+				while (addr) {
+					Node* next = addr->ptr;
+					delete addr;
+					addr = next;
 				}
 			}
+			for (; src; src = src->ptr)
+				push_back(*src->data);
+			return *this;
+		}
+		DoublyLinkedList& operator = (DoublyLinkedList&& obj) noexcept {
+			if (this != &obj) {
+				clear();
+				base_addr = obj.base_addr;
+				last_addr = obj.last_addr;
+				length = obj.length;
+				obj.detach();
+			}
+			return *this;
 		}
 		friend auto operator << (std::ostream& os, DoublyLinkedList const& obj) -> std::ostream& {
 			os << "[";
@@ -434,4 +904,698 @@ namespace linkedlist {
 			return os;
 		}
 	};
+
+	// Unrolled doubly linked list: every node stores up to node_capacity elements
+	// in an inline array sized to roughly node_bytes, so a scan takes one cache
+	// miss per node instead of one per element. Full nodes are split in half on
+	// insert and a node that falls under half full is merged with its successor
+	// when they fit together.
+	template <typename type, size_t node_bytes = 128> class UnrolledLinkedList final {
+		static constexpr size_t node_capacity = std::max<size_t>(4,
+			(node_bytes - 2 * sizeof(void*) - sizeof(size_t)) / sizeof(type));
+
+		struct Node {
+			Node* ptr = nullptr;
+			Node* prv = nullptr;
+			size_t count = 0;
+			alignas(type) unsigned char storage[node_capacity * sizeof(type)];
+
+			type* data() noexcept {
+				return reinterpret_cast<type*>(storage);
+			}
+		};
+	public:
+		class Iterator {
+			friend class UnrolledLinkedList;
+
+			Node* addr = nullptr;
+			index_t offset = 0;
+			const UnrolledLinkedList* list = nullptr;
+		public:
+			typedef std::bidirectional_iterator_tag iterator_category;
+			typedef type value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef type* pointer;
+			typedef type& reference;
+
+			Iterator(void) = default;
+			Iterator(Node* ptr, index_t offset_p, const UnrolledLinkedList* list_p)
+				: addr(ptr), offset(offset_p), list(list_p) {}
+
+			type& operator * () const {
+				return addr->data()[offset];
+			}
+			type* operator -> () const {
+				return addr->data() + offset;
+			}
+			Iterator& operator ++ () {
+				if (++offset == addr->count) {
+					addr = addr->ptr;
+					offset = 0;
+				}
+				return *this;
+			}
+			Iterator operator ++ (int) {
+				Iterator temp = *this;
+				++(*this);
+				return temp;
+			}
+			Iterator& operator -- () {
+				if (!addr) {
+					addr = list->last_addr;
+					offset = addr->count - 1;
+				}
+				else if (!offset--) {
+					addr = addr->prv;
+					offset = addr->count - 1;
+				}
+				return *this;
+			}
+			Iterator operator -- (int) {
+				Iterator temp = *this;
+				--(*this);
+				return temp;
+			}
+			friend bool operator == (const Iterator& a, const Iterator& b) {
+				return a.addr == b.addr && a.offset == b.offset;
+			}
+			friend bool operator != (const Iterator& a, const Iterator& b) {
+				return !(a == b);
+			}
+		};
+	private:
+		Node* base_addr = nullptr;
+		Node* last_addr = nullptr;
+		size_t length = 0;
+
+		// links a new empty node after prev (or at the front if prev is null)
+		Node* link_after(Node* prev) {
+			Node* node = new Node;
+			node->prv = prev;
+			node->ptr = (prev) ? prev->ptr : base_addr;
+			(node->ptr ? node->ptr->prv : last_addr) = node;
+			(prev ? prev->ptr : base_addr) = node;
+			return node;
+		}
+		void unlink(Node* node) noexcept {
+			(node->prv ? node->prv->ptr : base_addr) = node->ptr;
+			(node->ptr ? node->ptr->prv : last_addr) = node->prv;
+			delete node;
+		}
+		// move count elements into uninitialized dst, front to back (for dst < src)
+		// or back to front (for dst > src)
+		static void move_range(type* dst, type* src, size_t count) {
+			for (index_t i = 0; i < count; i++) {
+				new (dst + i) type(std::move(src[i]));
+				src[i].~type();
+			}
+		}
+		static void move_range_backward(type* dst, type* src, size_t count) {
+			for (index_t i = count; i--;) {
+				new (dst + i) type(std::move(src[i]));
+				src[i].~type();
+			}
+		}
+		// moves the elements from index at onwards into a new node after node
+		Node* split(Node* node, index_t at) {
+			Node* next = link_after(node);
+			move_range(next->data(), node->data() + at, node->count - at);
+			next->count = node->count - at;
+			node->count = at;
+			return next;
+		}
+		Iterator locate(index_t index) const {
+			if (index >= length)
+				throw linkedlist::index_error();
+			if (index < length / 2) {
+				Node* addr = base_addr;
+				for (; index >= addr->count; addr = addr->ptr)
+					index -= addr->count;
+				return Iterator(addr, index, this);
+			}
+			index_t back = length - 1 - index;
+			Node* addr = last_addr;
+			for (; back >= addr->count; addr = addr->prv)
+				back -= addr->count;
+			return Iterator(addr, addr->count - 1 - back, this);
+		}
+	public:
+		UnrolledLinkedList(void) = default;
+		UnrolledLinkedList(std::initializer_list<type> const& list) {
+			for (auto const& obj : list) {
+				push_back(obj);
+			}
+		}
+		UnrolledLinkedList(UnrolledLinkedList const& obj) {
+			for (Node* addr = obj.base_addr; addr; addr = addr->ptr) {
+				Node* node = link_after(last_addr);
+				for (index_t i = 0; i < addr->count; i++, node->count++)
+					new (node->data() + i) type(addr->data()[i]);
+			}
+			length = obj.length;
+		}
+		UnrolledLinkedList(UnrolledLinkedList&& obj) noexcept {
+			std::swap(base_addr, obj.base_addr);
+			std::swap(last_addr, obj.last_addr);
+			std::swap(length, obj.length);
+		}
+		UnrolledLinkedList& operator = (UnrolledLinkedList obj) noexcept {
+			std::swap(base_addr, obj.base_addr);
+			std::swap(last_addr, obj.last_addr);
+			std::swap(length, obj.length);
+			return *this;
+		}
+		~UnrolledLinkedList() {
+			clear();
+		}
+
+		Iterator insert(Iterator pos, type const& obj) {
+			Node* node = pos.addr;
+			index_t offset = pos.offset;
+			if (!node) {
+				node = last_addr;
+				if (!node || node->count == node_capacity)
+					node = link_after(last_addr);
+				offset = node->count;
+			}
+			else if (node->count == node_capacity) {
+				size_t half = node_capacity / 2;
+				split(node, half);
+				if (offset > half) {
+					node = node->ptr;
+					offset -= half;
+				}
+			}
+			move_range_backward(node->data() + offset + 1, node->data() + offset, node->count - offset);
+			new (node->data() + offset) type(obj);
+			node->count++;
+			length++;
+			return Iterator(node, offset, this);
+		}
+		Iterator erase(Iterator pos) {
+			Node* node = pos.addr;
+			index_t offset = pos.offset;
+			node->data()[offset].~type();
+			move_range(node->data() + offset, node->data() + offset + 1, node->count - offset - 1);
+			node->count--;
+			length--;
+			if (!node->count) {
+				Node* next = node->ptr;
+				unlink(node);
+				return Iterator(next, 0, this);
+			}
+			Node* next = node->ptr;
+			if (next && node->count < node_capacity / 2 && node->count + next->count <= node_capacity) {
+				move_range(node->data() + node->count, next->data(), next->count);
+				node->count += next->count;
+				next->count = 0;
+				unlink(next);
+			}
+			if (offset < node->count)
+				return Iterator(node, offset, this);
+			return Iterator(node->ptr, 0, this);
+		}
+		void push_back(type const& obj) {
+			insert(end(), obj);
+		}
+		void push_front(type const& obj) {
+			if (!base_addr || base_addr->count == node_capacity)
+				link_after(nullptr);
+			insert(Iterator(base_addr, 0, this), obj);
+		}
+		void pop_back() {
+			if (!length)
+				throw linkedlist::list_empty_error();
+			erase(Iterator(last_addr, last_addr->count - 1, this));
+		}
+		void pop_front() {
+			if (!length)
+				throw linkedlist::list_empty_error();
+			erase(begin());
+		}
+		// moves every element of list in front of pos; only the node holding pos
+		// is split, nothing is copied per element
+		void splice(Iterator pos, UnrolledLinkedList&& list) {
+			if (!list.base_addr || &list == this)
+				return;
+			Node* before = (pos.addr) ? pos.addr->prv : last_addr;
+			if (pos.addr && pos.offset) {
+				split(pos.addr, pos.offset);
+				before = pos.addr;
+			}
+			Node* after = (before) ? before->ptr : base_addr;
+			list.base_addr->prv = before;
+			list.last_addr->ptr = after;
+			(before ? before->ptr : base_addr) = list.base_addr;
+			(after ? after->prv : last_addr) = list.last_addr;
+			length += list.length;
+			list.base_addr = list.last_addr = nullptr;
+			list.length = 0;
+		}
+		void clear() noexcept {
+			for (Node* addr = base_addr; addr;) {
+				Node* next = addr->ptr;
+				if constexpr (!std::is_trivially_destructible_v<type>) {
+					for (index_t i = 0; i < addr->count; i++)
+						addr->data()[i].~type();
+				}
+				delete addr;
+				addr = next;
+			}
+			base_addr = last_addr = nullptr;
+			length = 0;
+		}
+		Iterator begin() const {
+			return Iterator(base_addr, 0, this);
+		}
+		Iterator end() const {
+			return Iterator(nullptr, 0, this);
+		}
+		type& front() const {
+			if (!length)
+				throw linkedlist::list_empty_error();
+			return base_addr->data()[0];
+		}
+		type& back() const {
+			if (!length)
+				throw linkedlist::list_empty_error();
+			return last_addr->data()[last_addr->count - 1];
+		}
+		type& at(index_t const index) const {
+			return *locate(index);
+		}
+		type& operator [] (index_t index) const {
+			return *locate(index);
+		}
+		size_t size() const noexcept {
+			return length;
+		}
+		bool empty() const noexcept {
+			return !length;
+		}
+		friend auto operator << (std::ostream& os, UnrolledLinkedList const& obj) -> std::ostream& {
+			os << "[";
+			index_t i = 0;
+			for (auto it = obj.begin(); it != obj.end(); ++it, i++)
+				os << *it << ((i != obj.size() - 1) ? ", " : "");
+			os << "]";
+			return os;
+		}
+	};
+
+	// Indexable skip list: a sequence (not a sorted set) where every link also
+	// records how many elements it jumps over. Positional lookup, insert and
+	// erase follow the express lanes and take expected O(log n) steps, where
+	// the plain linked lists walk O(n) from the head.
+	template <typename type> class IndexableSkipList final {
+		static constexpr int max_level = 32;
+
+		struct Node;
+		struct Link {
+			Node* ptr;
+			size_t width;
+		};
+		struct Node {
+			Node(int height_p) : height(height_p) {
+				links = new Link[height];
+			}
+			template <typename... args_t> Node(int height_p, args_t&&... args)
+				: height(height_p), data(new type(std::forward<args_t>(args)...)) {
+				links = new Link[height];
+			}
+			~Node() {
+				delete data;
+				delete[] links;
+			}
+			int height;
+			type* data = nullptr;
+			Link* links;
+		};
+		class Iterator {
+			Node* addr = nullptr;
+		public:
+			Iterator(Node* ptr) : addr(ptr) {}
+
+			type& operator * () const {
+				return *addr->data;
+			}
+			Iterator& operator ++ () {
+				addr = addr->links[0].ptr;
+				return *this;
+			}
+			Iterator operator ++ (int) {
+				Iterator temp = *this;
+				++(*this);
+				return temp;
+			}
+			friend bool operator == (const Iterator& a, const Iterator& b) {
+				return a.addr == b.addr;
+			}
+			friend bool operator != (const Iterator& a, const Iterator& b) {
+				return a.addr != b.addr;
+			}
+		};
+
+		// head sits at position -1, a null link points at position length
+		Node* head = new Node(max_level);
+		size_t length = 0;
+		uint64_t seed = 0x9E3779B97F4A7C15ull;
+
+		int random_level() noexcept {
+			seed ^= seed << 13;
+			seed ^= seed >> 7;
+			seed ^= seed << 17;
+			int level = 1;
+			for (uint64_t bits = seed; (bits & 1) && level < max_level; bits >>= 1)
+				level++;
+			return level;
+		}
+		// fills preds with the last node before position index on every level and
+		// distance with how far that node is from the head
+		void find(index_t index, Node** preds, size_t* distance) const noexcept {
+			Node* node = head;
+			size_t position = 0;
+			for (int level = max_level - 1; level >= 0; level--) {
+				while (node->links[level].ptr && position + node->links[level].width <= index) {
+					position += node->links[level].width;
+					node = node->links[level].ptr;
+				}
+				preds[level] = node;
+				distance[level] = position;
+			}
+		}
+	public:
+		IndexableSkipList(void) {
+			for (int level = 0; level < max_level; level++)
+				head->links[level] = { nullptr, 1 };
+		}
+		IndexableSkipList(std::initializer_list<type> const& list) : IndexableSkipList() {
+			for (auto const& obj : list) {
+				push_back(obj);
+			}
+		}
+		IndexableSkipList(IndexableSkipList const&) = delete;
+		IndexableSkipList& operator = (IndexableSkipList const&) = delete;
+		~IndexableSkipList() {
+			for (Node* addr = head; addr;) {
+				Node* next = addr->links[0].ptr;
+				delete addr;
+				addr = next;
+			}
+		}
+
+		void insert(type const& obj, index_t index) {
+			if (index > length)
+				index = length;
+			Node* preds[max_level];
+			size_t distance[max_level];
+			find(index, preds, distance);
+			int height = random_level();
+			Node* node = new Node(height, obj);
+			for (int level = 0; level < max_level; level++) {
+				Link& link = preds[level]->links[level];
+				if (level < height) {
+					// widths count steps, the head being step 0 and the new node step index + 1
+					size_t steps = distance[level] + link.width - index;
+					node->links[level] = { link.ptr, steps };
+					link = { node, index + 1 - distance[level] };
+				}
+				else {
+					link.width++;
+				}
+			}
+			length++;
+		}
+		void push_back(type const& obj) {
+			insert(obj, length);
+		}
+		void erase(index_t index) {
+			if (index >= length)
+				throw linkedlist::index_error();
+			Node* preds[max_level];
+			size_t distance[max_level];
+			find(index, preds, distance);
+			Node* node = preds[0]->links[0].ptr;
+			for (int level = 0; level < max_level; level++) {
+				Link& link = preds[level]->links[level];
+				if (level < node->height)
+					link = { node->links[level].ptr, link.width + node->links[level].width - 1 };
+				else
+					link.width--;
+			}
+			delete node;
+			length--;
+		}
+		type& operator [] (index_t index) const {
+			if (index >= length)
+				throw linkedlist::index_error();
+			Node* node = head;
+			size_t position = 0;
+			for (int level = max_level - 1; level >= 0; level--) {
+				while (node->links[level].ptr && position + node->links[level].width <= index + 1) {
+					position += node->links[level].width;
+					node = node->links[level].ptr;
+				}
+			}
+			return *node->data;
+		}
+		type& at(index_t const index) const {
+			return (*this)[index];
+		}
+		Iterator begin() const {
+			return Iterator(head->links[0].ptr);
+		}
+		Iterator end() const {
+			return Iterator(nullptr);
+		}
+		size_t size() const noexcept {
+			return length;
+		}
+		bool empty() const noexcept {
+			return !length;
+		}
+		friend auto operator << (std::ostream& os, IndexableSkipList const& obj) -> std::ostream& {
+			os << "[";
+			index_t i = 0;
+			for (auto it = obj.begin(); it != obj.end(); ++it, i++)
+				os << *it << ((i != obj.size() - 1) ? ", " : "");
+			os << "]";
+			return os;
+		}
+	};
+
+	// Hook for IntrusiveList. Embed it in the element type, as a base class or
+	// as a member; the list links the hooks themselves and never allocates or
+	// copies elements, so an element must outlive its membership in a list.
+	struct ListHook {
+		ListHook* ptr = nullptr;
+		ListHook* prv = nullptr;
+
+		bool linked() const noexcept {
+			return ptr;
+		}
+	};
+
+	// selects a ListHook base class of type as the list hook
+	template <typename type> struct base_hook {
+		static ListHook* to_hook(type* obj) noexcept {
+			return static_cast<ListHook*>(obj);
+		}
+		static type* to_object(ListHook* hook) noexcept {
+			return static_cast<type*>(hook);
+		}
+	};
+	// selects the ListHook member of type at offset as the list hook, as in
+	// member_hook<Task, offsetof(Task, hook)>; offsetof is only defined for
+	// standard-layout types
+	template <typename type, size_t offset> struct member_hook {
+		static_assert(std::is_standard_layout_v<type>, "member_hook needs a standard-layout type for offsetof");
+		static_assert(offset + sizeof(ListHook) <= sizeof(type), "The hook offset lies outside the type");
+
+		static ListHook* to_hook(type* obj) noexcept {
+			return reinterpret_cast<ListHook*>(reinterpret_cast<char*>(obj) + offset);
+		}
+		static type* to_object(ListHook* hook) noexcept {
+			return reinterpret_cast<type*>(reinterpret_cast<char*>(hook) - offset);
+		}
+	};
+
+	// Circular doubly linked list threaded through hooks inside the elements.
+	// push, insert, erase and splice only relink pointers, and erase takes the
+	// element itself, so removing an object you hold a reference to is O(1).
+	template <typename type, typename hook_t = base_hook<type>> class IntrusiveList final {
+		ListHook head;
+		size_t length = 0;
+
+		static void link_before(ListHook* next, ListHook* hook) noexcept {
+			hook->ptr = next;
+			hook->prv = next->prv;
+			next->prv->ptr = hook;
+			next->prv = hook;
+		}
+		static void unlink(ListHook* hook) noexcept {
+			hook->prv->ptr = hook->ptr;
+			hook->ptr->prv = hook->prv;
+			hook->ptr = hook->prv = nullptr;
+		}
+		void reset() noexcept {
+			head.ptr = head.prv = &head;
+			length = 0;
+		}
+	public:
+		class Iterator {
+			friend class IntrusiveList;
+
+			ListHook* addr = nullptr;
+		public:
+			typedef std::bidirectional_iterator_tag iterator_category;
+			typedef type value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef type* pointer;
+			typedef type& reference;
+
+			Iterator(void) = default;
+			Iterator(ListHook* ptr) : addr(ptr) {}
+
+			type& operator * () const {
+				return *hook_t::to_object(addr);
+			}
+			type* operator -> () const {
+				return hook_t::to_object(addr);
+			}
+			Iterator& operator ++ () {
+				addr = addr->ptr;
+				return *this;
+			}
+			Iterator operator ++ (int) {
+				Iterator temp = *this;
+				addr = addr->ptr;
+				return temp;
+			}
+			Iterator& operator -- () {
+				addr = addr->prv;
+				return *this;
+			}
+			Iterator operator -- (int) {
+				Iterator temp = *this;
+				addr = addr->prv;
+				return temp;
+			}
+			friend bool operator == (const Iterator& a, const Iterator& b) {
+				return a.addr == b.addr;
+			}
+			friend bool operator != (const Iterator& a, const Iterator& b) {
+				return a.addr != b.addr;
+			}
+		};
+
+		IntrusiveList(void) {
+			reset();
+		}
+		IntrusiveList(IntrusiveList const&) = delete;
+		IntrusiveList& operator = (IntrusiveList const&) = delete;
+		IntrusiveList(IntrusiveList&& obj) noexcept {
+			reset();
+			splice(end(), obj);
+		}
+		IntrusiveList& operator = (IntrusiveList&& obj) noexcept {
+			if (this != &obj) {
+				clear();
+				splice(end(), obj);
+			}
+			return *this;
+		}
+		~IntrusiveList() {
+			clear();
+		}
+
+		Iterator insert(Iterator pos, type& obj) noexcept {
+			ListHook* hook = hook_t::to_hook(&obj);
+			link_before(pos.addr, hook);
+			length++;
+			return Iterator(hook);
+		}
+		void push_back(type& obj) noexcept {
+			insert(end(), obj);
+		}
+		void push_front(type& obj) noexcept {
+			insert(begin(), obj);
+		}
+		// obj must currently be linked into this list
+		void erase(type& obj) noexcept {
+			unlink(hook_t::to_hook(&obj));
+			length--;
+		}
+		Iterator erase(Iterator pos) noexcept {
+			Iterator next(pos.addr->ptr);
+			erase(*pos);
+			return next;
+		}
+		type& pop_front() {
+			if (!length)
+				throw linkedlist::list_empty_error();
+			type& obj = front();
+			erase(obj);
+			return obj;
+		}
+		type& pop_back() {
+			if (!length)
+				throw linkedlist::list_empty_error();
+			type& obj = back();
+			erase(obj);
+			return obj;
+		}
+		// moves every element of list in front of pos
+		void splice(Iterator pos, IntrusiveList& list) noexcept {
+			if (list.empty() || &list == this)
+				return;
+			ListHook* first = list.head.ptr;
+			ListHook* last = list.head.prv;
+			ListHook* next = pos.addr;
+			first->prv = next->prv;
+			next->prv->ptr = first;
+			last->ptr = next;
+			next->prv = last;
+			length += list.length;
+			list.reset();
+		}
+		// moves obj, which is linked into list, in front of pos
+		void splice(Iterator pos, IntrusiveList& list, type& obj) noexcept {
+			list.erase(obj);
+			insert(pos, obj);
+		}
+		Iterator iterator_to(type& obj) const noexcept {
+			return Iterator(hook_t::to_hook(&obj));
+		}
+		void clear() noexcept {
+			for (ListHook* hook = head.ptr; hook != &head;) {
+				ListHook* next = hook->ptr;
+				hook->ptr = hook->prv = nullptr;
+				hook = next;
+			}
+			reset();
+		}
+		type& front() const {
+			if (!length)
+				throw linkedlist::list_empty_error();
+			return *hook_t::to_object(head.ptr);
+		}
+		type& back() const {
+			if (!length)
+				throw linkedlist::list_empty_error();
+			return *hook_t::to_object(head.prv);
+		}
+		Iterator begin() noexcept {
+			return Iterator(head.ptr);
+		}
+		Iterator end() noexcept {
+			return Iterator(&head);
+		}
+		size_t size() const noexcept {
+			return length;
+		}
+		bool empty() const noexcept {
+			return !length;
+		}
+	};
 }
\ No newline at end of file
@@ -9,6 +9,10 @@
 #include "string.h"
 #include "graph.h"
 #include "matrix.h"
+#include "threadpool.h"
+#include "cache.h"
+#include "hashmap.h"
+#include "filter.h"
 
 using namespace tree;
 using namespace string;
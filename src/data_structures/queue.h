@@ -23,9 +23,32 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <iostream>
 #include <exception>
+#include <memory>
+#include <new>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+
+#include "array.h"
 
 namespace queue {
 	typedef size_t index_t;
+
+	// used to keep data written by different threads on separate cache lines;
+	// the concurrent containers in the other headers use this one as well
+	constexpr size_t cache_line_size = 64;
+
+	template <typename type>
+	concept supports_comparison = requires(type obj1, type obj2) {
+		{obj1 > obj2} noexcept -> std::convertible_to<bool>;
+		{obj1 < obj2} noexcept -> std::convertible_to<bool>;
+	};
 	
 	struct queue_empty_error : public std::exception {
 		virtual const char* what() const noexcept {
@@ -37,6 +60,16 @@ namespace queue {
 			return "Queue is full";
 		}
 	};
+	struct out_of_range : public std::exception {
+		virtual const char* what() const noexcept {
+			return "Queue index out of range";
+		}
+	};
+	struct invalid_key_error : public std::exception {
+		virtual const char* what() const noexcept {
+			return "New key would move the element away from the top of the heap";
+		}
+	};
 	struct invalid_size_multiplier_error : public std::exception {
 		virtual const char* what() const noexcept {
 			return "Size multiplier must be greater than 0";
@@ -44,24 +77,57 @@ namespace queue {
 	};
 
 	template <typename type> class LinkedQueue final {
+		// the element is stored inline and only exists while the node is in the
+		// queue; nodes on the free list are raw storage
 		struct Node {
-			Node(type data, Node* ptr) {
-				if (this->data)
-					*this->data = data;
-				this->ptr = ptr;
-			}
-			~Node() {
-				free((void*)this->data);
+			explicit Node(Node* ptr) : ptr(ptr) {}
+
+			type* data() noexcept {
+				return reinterpret_cast<type*>(storage);
 			}
-			// using malloc here because we will need to copy a local variable to
-			// heap and I am not aware of any way of doing this with new operator
-			type* data = static_cast<type*>(malloc(sizeof(type)));
+			alignas(type) unsigned char storage[sizeof(type)];
 			Node* ptr;
 		};
 
 		Node* base_addr = nullptr;
 		Node* last_addr = nullptr;
 		size_t length = 0;
+		// popped nodes are kept here (up to free_limit) and reused by push
+		Node* free_addr = nullptr;
+		size_t free_length = 0;
+		size_t free_limit = 64;
+
+		Node* acquire(type const& obj) {
+			Node* node = free_addr;
+			if (node) {
+				free_addr = node->ptr;
+				free_length--;
+			}
+			else
+				node = new Node(nullptr);
+			try {
+				new (node->storage) type(obj);
+			}
+			catch (...) {
+				node->ptr = free_addr;
+				free_addr = node;
+				free_length++;
+				throw;
+			}
+			node->ptr = nullptr;
+			return node;
+		}
+		// destroys the element and keeps the node for the next push
+		void recycle(Node* node) {
+			node->data()->~type();
+			if (free_length >= free_limit) {
+				delete node;
+				return;
+			}
+			node->ptr = free_addr;
+			free_addr = node;
+			free_length++;
+		}
 	public:
 		LinkedQueue(void) = default;
 		LinkedQueue(std::initializer_list<type> const& list) {
@@ -69,16 +135,31 @@ namespace queue {
 				push(obj);
 			}
 		}
+		LinkedQueue(LinkedQueue const&) = delete;
+		LinkedQueue& operator = (LinkedQueue const&) = delete;
+		~LinkedQueue() {
+			for (Node* addr = base_addr; addr;) {
+				Node* next = addr->ptr;
+				addr->data()->~type();
+				delete addr;
+				addr = next;
+			}
+			for (Node* addr = free_addr; addr;) {
+				Node* next = addr->ptr;
+				delete addr;
+				addr = next;
+			}
+		}
 
 		type& back() {
 			if (!length)
 				throw queue::queue_empty_error();
-			return *last_addr->data;
+			return *last_addr->data();
 		}
 		const type& back() const {
 			if (!length)
 				throw queue::queue_empty_error();
-			return *last_addr->data;
+			return *last_addr->data();
 		}
 
 		bool empty() const {
@@ -88,32 +169,43 @@ namespace queue {
 		type& front() {
 			if (!length)
 				throw queue::queue_empty_error();
-			return *base_addr->data;
+			return *base_addr->data();
 		}
 		const type& front() const {
 			if (!length)
 				throw queue::queue_empty_error();
-			return *base_addr->data;
+			return *base_addr->data();
 		}
 
 		void pop() {
 			if (empty())
 				throw queue::queue_empty_error();
 			length--;
+			Node* node = base_addr;
 			base_addr = base_addr->ptr;
 			if (!base_addr)
 				last_addr = nullptr;
-			delete base_addr;
+			recycle(node);
 		}
 
 		void push(const type& obj) {
+			Node* node = acquire(obj);
 			length++;
 			if (!last_addr) {
-				base_addr = last_addr = new Node(obj, nullptr);
+				base_addr = last_addr = node;
 				return;
 			}
-			last_addr->ptr = new Node(obj, nullptr);
-			last_addr = last_addr->ptr;
+			last_addr->ptr = node;
+			last_addr = node;
+		}
+
+		// pre-allocates nodes so that the next size pushes do not allocate,
+		// raising the free list bound to size if needed
+		void reserve(size_t size) {
+			if (size > free_limit)
+				free_limit = size;
+			for (; free_length < size; free_length++)
+				free_addr = new Node(free_addr);
 		}
 
 		size_t size() const {
@@ -121,7 +213,12 @@ namespace queue {
 		}
 
 		void swap(LinkedQueue<type>& x) noexcept {
-
+			std::swap(base_addr, x.base_addr);
+			std::swap(last_addr, x.last_addr);
+			std::swap(length, x.length);
+			std::swap(free_addr, x.free_addr);
+			std::swap(free_length, x.free_length);
+			std::swap(free_limit, x.free_limit);
 		}
 		
 		operator type& () const {
@@ -155,49 +252,205 @@ namespace queue {
 			os << "[";
 			index_t i = 0;
 			for (Node* addr = obj.base_addr; addr; addr = addr->ptr, i++)
-				os << *(addr->data) << ((i != obj.size() - 1) ? ", " : "");
+				os << *addr->data() << ((i != obj.size() - 1) ? ", " : "");
 			os << "]";
 			return os;
 		}
 	};
 
+	// Growable ring buffer deque. Capacity is always a power of two so slots are
+	// found with a mask instead of a division, and storage is only reallocated
+	// when the ring is full (or on an explicit reserve/shrink_to_fit).
 	template <typename type, size_t size_multiplier = 4> class ArrayQueue final {
-		type* base_addr;
-		index_t head = NULL;
-		index_t tail = NULL;
+		type* base_addr = nullptr;
+		index_t head = 0;
 		size_t length = 0;
+		size_t capacity_v = 0;
+
+		static size_t round_up(size_t n) noexcept {
+			size_t capacity = 1;
+			while (capacity < n)
+				capacity <<= 1;
+			return capacity;
+		}
+		type* slot(index_t index) const noexcept {
+			return base_addr + ((head + index) & (capacity_v - 1));
+		}
+		// moves the elements to the front of addr, a block of the given capacity,
+		// and frees the old one
+		void relocate(type* addr, size_t capacity) {
+			if constexpr (std::is_trivially_copyable_v<type>) {
+				size_t first = std::min(length, capacity_v - head);
+				if (length) {
+					memcpy(addr, base_addr + head, first * sizeof(type));
+					memcpy(addr + first, base_addr, (length - first) * sizeof(type));
+				}
+			}
+			else {
+				for (index_t i = 0; i < length; i++) {
+					new (addr + i) type(std::move(*slot(i)));
+					slot(i)->~type();
+				}
+			}
+			if (base_addr)
+				std::allocator<type>().deallocate(base_addr, capacity_v);
+			base_addr = addr;
+			capacity_v = capacity;
+			head = 0;
+		}
+		void relocate(size_t capacity) {
+			relocate((capacity) ? std::allocator<type>().allocate(capacity) : nullptr, capacity);
+		}
+		// a full queue grows into a new block; the element is constructed at
+		// offset in it before the old block goes away, because args may refer
+		// to an element of this queue
+		template <typename... args_t> type* grow_with(index_t offset, args_t&&... args) {
+			size_t capacity = (capacity_v) ? capacity_v * 2 : 4;
+			type* addr = std::allocator<type>().allocate(capacity);
+			try {
+				new (addr + offset) type(std::forward<args_t>(args)...);
+			}
+			catch (...) {
+				std::allocator<type>().deallocate(addr, capacity);
+				throw;
+			}
+			relocate(addr, capacity);
+			return addr + offset;
+		}
 	public:
-		explicit ArrayQueue(const size_t size) : length(size) {
-			base_addr = new type[size];
+		ArrayQueue(void) = default;
+		explicit ArrayQueue(const size_t size) {
+			reserve(size);
 		}
 		ArrayQueue(std::initializer_list<type> const& list) {
 			if (!size_multiplier)
 				throw invalid_size_multiplier_error();
-			length = list.size() * size_multiplier;
-			base_addr = new type[length];
+			reserve(list.size() * size_multiplier);
 			for (auto const& obj : list)
-				enqueue(obj);
+				push(obj);
+		}
+		ArrayQueue(ArrayQueue const& obj) {
+			reserve(obj.length);
+			for (index_t i = 0; i < obj.length; i++)
+				push(*obj.slot(i));
+		}
+		ArrayQueue(ArrayQueue&& obj) noexcept {
+			swap(obj);
+		}
+		ArrayQueue& operator = (ArrayQueue obj) noexcept {
+			swap(obj);
+			return *this;
+		}
+		~ArrayQueue() {
+			clear();
+			if (base_addr)
+				std::allocator<type>().deallocate(base_addr, capacity_v);
+		}
+
+		template <typename... args_t> type& emplace_back(args_t&&... args) {
+			type* addr = (length == capacity_v) ?
+				grow_with(length, std::forward<args_t>(args)...) :
+				new (slot(length)) type(std::forward<args_t>(args)...);
+			length++;
+			return *addr;
+		}
+		template <typename... args_t> type& emplace_front(args_t&&... args) {
+			type* addr;
+			if (length == capacity_v) {
+				// the old elements go to the front of the new block, so the new
+				// first element wraps around to its last slot
+				addr = grow_with((capacity_v) ? capacity_v * 2 - 1 : 3, std::forward<args_t>(args)...);
+				head = capacity_v - 1;
+			}
+			else {
+				index_t index = (head - 1) & (capacity_v - 1);
+				addr = new (base_addr + index) type(std::forward<args_t>(args)...);
+				head = index;
+			}
+			length++;
+			return *addr;
 		}
 		void push(type const& obj) {
-			if (!head && tail == length)
-				throw queue_full_error();
-			base_addr[tail % length] = obj;
-			tail++;
+			emplace_back(obj);
 		}
-		type& pop() {
-			if (head == tail)
+		void push_back(type const& obj) {
+			emplace_back(obj);
+		}
+		void push_front(type const& obj) {
+			emplace_front(obj);
+		}
+		type pop() {
+			return pop_front();
+		}
+		type pop_front() {
+			if (!length)
 				throw queue_empty_error();
-			type& val = base_addr[head];
-			head++;
+			type* addr = slot(0);
+			type val = std::move(*addr);
+			addr->~type();
+			head = (head + 1) & (capacity_v - 1);
+			length--;
+			return val;
+		}
+		type pop_back() {
+			if (!length)
+				throw queue_empty_error();
+			type* addr = slot(length - 1);
+			type val = std::move(*addr);
+			addr->~type();
+			length--;
 			return val;
 		}
 		type& front() const {
-			if (head == tail)
+			if (!length)
 				throw queue_empty_error();
-			return base_addr[head];
+			return *slot(0);
+		}
+		type& back() const {
+			if (!length)
+				throw queue_empty_error();
+			return *slot(length - 1);
+		}
+		type& operator [] (index_t index) const {
+			return *slot(index);
+		}
+		type& at(index_t index) const {
+			if (index >= length)
+				throw queue::out_of_range();
+			return *slot(index);
+		}
+		void reserve(size_t size) {
+			if (size > capacity_v)
+				relocate(round_up(size));
+		}
+		// releases unused capacity, keeping the smallest power of two that fits
+		void shrink_to_fit() {
+			size_t capacity = (length) ? round_up(length) : 0;
+			if (capacity < capacity_v)
+				relocate(capacity);
+		}
+		void clear() noexcept {
+			if constexpr (!std::is_trivially_destructible_v<type>) {
+				for (index_t i = 0; i < length; i++)
+					slot(i)->~type();
+			}
+			head = 0;
+			length = 0;
+		}
+		void swap(ArrayQueue& obj) noexcept {
+			std::swap(base_addr, obj.base_addr);
+			std::swap(head, obj.head);
+			std::swap(length, obj.length);
+			std::swap(capacity_v, obj.capacity_v);
 		}
 		size_t size() const noexcept {
-			return tail - head;
+			return length;
+		}
+		size_t capacity() const noexcept {
+			return capacity_v;
+		}
+		bool empty() const noexcept {
+			return !length;
 		}
 		type* get_array() const noexcept {
 			return base_addr;
@@ -208,9 +461,909 @@ namespace queue {
 		friend auto operator << (std::ostream& os, ArrayQueue const& obj) -> std::ostream& {
 			os << "[";
 			for (index_t i = 0; i < obj.length; i++)
-				os << obj.base_addr[i] << ((i != obj.length - 1) ? ", " : "");
+				os << *obj.slot(i) << ((i != obj.length - 1) ? ", " : "");
 			os << "]";
 			return os;
 		}
 	};
+
+	// Lock-free single-producer/single-consumer ring. Head and tail live on their
+	// own cache lines and each side keeps a private copy of the other side's
+	// index, so the shared lines are only touched when the cached copy says the
+	// ring looks full (producer) or empty (consumer).
+	template <typename type> class SpscQueue final {
+		alignas(cache_line_size) std::atomic<index_t> head = 0;
+		index_t cached_tail = 0;
+		alignas(cache_line_size) std::atomic<index_t> tail = 0;
+		index_t cached_head = 0;
+		alignas(cache_line_size) type* base_addr = nullptr;
+		size_t capacity_v = 0;
+
+		type* slot(index_t index) const noexcept {
+			return base_addr + (index & (capacity_v - 1));
+		}
+	public:
+		explicit SpscQueue(const size_t size) {
+			capacity_v = 1;
+			while (capacity_v < size)
+				capacity_v <<= 1;
+			base_addr = std::allocator<type>().allocate(capacity_v);
+		}
+		SpscQueue(SpscQueue const&) = delete;
+		SpscQueue& operator = (SpscQueue const&) = delete;
+		~SpscQueue() {
+			if constexpr (!std::is_trivially_destructible_v<type>) {
+				for (index_t i = head.load(std::memory_order_relaxed); i != tail.load(std::memory_order_relaxed); i++)
+					slot(i)->~type();
+			}
+			std::allocator<type>().deallocate(base_addr, capacity_v);
+		}
+
+		// producer side
+		template <typename... args_t> bool try_emplace(args_t&&... args) {
+			index_t t = tail.load(std::memory_order_relaxed);
+			if (t - cached_head == capacity_v) {
+				cached_head = head.load(std::memory_order_acquire);
+				if (t - cached_head == capacity_v)
+					return false;
+			}
+			new (slot(t)) type(std::forward<args_t>(args)...);
+			tail.store(t + 1, std::memory_order_release);
+			return true;
+		}
+		bool try_push(type const& obj) {
+			return try_emplace(obj);
+		}
+		// pushes as many of the n objects as fit and returns how many were pushed
+		size_t push_n(const type* objs, size_t n) {
+			index_t t = tail.load(std::memory_order_relaxed);
+			if (capacity_v - (t - cached_head) < n)
+				cached_head = head.load(std::memory_order_acquire);
+			size_t count = std::min(n, capacity_v - (t - cached_head));
+			for (index_t i = 0; i < count; i++)
+				new (slot(t + i)) type(objs[i]);
+			if (count)
+				tail.store(t + count, std::memory_order_release);
+			return count;
+		}
+
+		// consumer side
+		bool try_pop(type& obj) {
+			index_t h = head.load(std::memory_order_relaxed);
+			if (h == cached_tail) {
+				cached_tail = tail.load(std::memory_order_acquire);
+				if (h == cached_tail)
+					return false;
+			}
+			type* addr = slot(h);
+			obj = std::move(*addr);
+			addr->~type();
+			head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+		// pops up to n objects into objs and returns how many were popped
+		size_t pop_n(type* objs, size_t n) {
+			index_t h = head.load(std::memory_order_relaxed);
+			if (cached_tail - h < n)
+				cached_tail = tail.load(std::memory_order_acquire);
+			size_t count = std::min(n, cached_tail - h);
+			for (index_t i = 0; i < count; i++) {
+				type* addr = slot(h + i);
+				objs[i] = std::move(*addr);
+				addr->~type();
+			}
+			if (count)
+				head.store(h + count, std::memory_order_release);
+			return count;
+		}
+
+		// only exact when called from one of the two sides with the other idle
+		size_t size() const noexcept {
+			// head first: tail only grows and never overtakes head, so a tail read
+			// afterwards is at least the head read, and the difference cannot wrap
+			index_t h = head.load(std::memory_order_acquire);
+			return tail.load(std::memory_order_acquire) - h;
+		}
+		bool empty() const noexcept {
+			return !size();
+		}
+		size_t capacity() const noexcept {
+			return capacity_v;
+		}
+	};
+
+	// Bounded multi-producer/multi-consumer queue after Dmitry Vyukov's design.
+	// Every cell carries a sequence number that tells producers and consumers
+	// whether it is theirs to take for the current lap, so the only contended
+	// writes are one CAS on enqueue_pos or dequeue_pos per operation.
+	// Blocking calls spin for a while, then park on the sequence of the cell that
+	// is holding them up; the side that changes that cell wakes them.
+	template <typename type> class MpmcQueue final {
+		static constexpr unsigned spin_limit = 128;
+
+		struct Cell {
+			std::atomic<index_t> sequence;
+			alignas(type) unsigned char storage[sizeof(type)];
+
+			type* data() noexcept {
+				return reinterpret_cast<type*>(storage);
+			}
+		};
+
+		alignas(cache_line_size) std::atomic<index_t> enqueue_pos = 0;
+		alignas(cache_line_size) std::atomic<index_t> dequeue_pos = 0;
+		alignas(cache_line_size) std::atomic<uint32_t> waiters = 0;
+		Cell* cells = nullptr;
+		size_t mask = 0;
+
+		Cell* claim_push(index_t& pos) noexcept {
+			pos = enqueue_pos.load(std::memory_order_relaxed);
+			while (true) {
+				Cell* cell = &cells[pos & mask];
+				intptr_t diff = static_cast<intptr_t>(cell->sequence.load(std::memory_order_acquire) - pos);
+				if (!diff) {
+					if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						return cell;
+				}
+				else if (diff < 0) {
+					return nullptr;
+				}
+				else {
+					pos = enqueue_pos.load(std::memory_order_relaxed);
+				}
+			}
+		}
+		Cell* claim_pop(index_t& pos) noexcept {
+			pos = dequeue_pos.load(std::memory_order_relaxed);
+			while (true) {
+				Cell* cell = &cells[pos & mask];
+				intptr_t diff = static_cast<intptr_t>(cell->sequence.load(std::memory_order_acquire) - (pos + 1));
+				if (!diff) {
+					if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						return cell;
+				}
+				else if (diff < 0) {
+					return nullptr;
+				}
+				else {
+					pos = dequeue_pos.load(std::memory_order_relaxed);
+				}
+			}
+		}
+		void publish(Cell* cell, index_t sequence) noexcept {
+			cell->sequence.store(sequence, std::memory_order_release);
+			// pairs with the fetch_add in park(), either we see the waiter or it
+			// sees the new sequence before going to sleep
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (waiters.load(std::memory_order_relaxed))
+				cell->sequence.notify_all();
+		}
+		void park(bool producer) noexcept {
+			index_t pos = (producer ? enqueue_pos : dequeue_pos).load(std::memory_order_relaxed);
+			Cell* cell = &cells[pos & mask];
+			index_t sequence = cell->sequence.load(std::memory_order_acquire);
+			if (static_cast<intptr_t>(sequence - (pos + !producer)) >= 0)
+				return;
+			waiters.fetch_add(1, std::memory_order_seq_cst);
+			cell->sequence.wait(sequence, std::memory_order_seq_cst);
+			waiters.fetch_sub(1, std::memory_order_relaxed);
+		}
+		Cell* wait_push(index_t& pos) noexcept {
+			for (unsigned spin = 0;; spin++) {
+				if (Cell* cell = claim_push(pos))
+					return cell;
+				if (spin >= spin_limit)
+					park(true);
+			}
+		}
+		Cell* wait_pop(index_t& pos) noexcept {
+			for (unsigned spin = 0;; spin++) {
+				if (Cell* cell = claim_pop(pos))
+					return cell;
+				if (spin >= spin_limit)
+					park(false);
+			}
+		}
+		// atomic::wait has no timeout, so timed waits back off with yield/sleep
+		template <typename claim_t, typename rep_t, typename period_t>
+		Cell* wait_for(claim_t const& claim, index_t& pos, std::chrono::duration<rep_t, period_t> const& timeout) {
+			auto deadline = std::chrono::steady_clock::now() + timeout;
+			for (unsigned spin = 0;; spin++) {
+				if (Cell* cell = claim(pos))
+					return cell;
+				if (std::chrono::steady_clock::now() >= deadline)
+					return nullptr;
+				if (spin >= spin_limit)
+					std::this_thread::sleep_for(std::chrono::microseconds(50));
+				else
+					std::this_thread::yield();
+			}
+		}
+		template <typename... args_t> void construct(Cell* cell, index_t pos, args_t&&... args) {
+			new (cell->storage) type(std::forward<args_t>(args)...);
+			publish(cell, pos + 1);
+		}
+		void take(Cell* cell, index_t pos, type& obj) {
+			obj = std::move(*cell->data());
+			cell->data()->~type();
+			publish(cell, pos + mask + 1);
+		}
+	public:
+		explicit MpmcQueue(const size_t size) {
+			size_t capacity = 2;
+			while (capacity < size)
+				capacity <<= 1;
+			cells = new Cell[capacity];
+			mask = capacity - 1;
+			for (index_t i = 0; i < capacity; i++)
+				cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		MpmcQueue(MpmcQueue const&) = delete;
+		MpmcQueue& operator = (MpmcQueue const&) = delete;
+		~MpmcQueue() {
+			if constexpr (!std::is_trivially_destructible_v<type>) {
+				index_t end = enqueue_pos.load(std::memory_order_relaxed);
+				for (index_t i = dequeue_pos.load(std::memory_order_relaxed); i != end; i++)
+					cells[i & mask].data()->~type();
+			}
+			delete[] cells;
+		}
+
+		template <typename... args_t> bool try_emplace(args_t&&... args) {
+			index_t pos;
+			Cell* cell = claim_push(pos);
+			if (cell)
+				construct(cell, pos, std::forward<args_t>(args)...);
+			return cell;
+		}
+		bool try_push(type const& obj) {
+			return try_emplace(obj);
+		}
+		template <typename rep_t, typename period_t>
+		bool try_push_for(type const& obj, std::chrono::duration<rep_t, period_t> const& timeout) {
+			index_t pos;
+			Cell* cell = wait_for([this](index_t& pos) { return claim_push(pos); }, pos, timeout);
+			if (cell)
+				construct(cell, pos, obj);
+			return cell;
+		}
+		template <typename... args_t> void emplace(args_t&&... args) {
+			index_t pos;
+			Cell* cell = wait_push(pos);
+			construct(cell, pos, std::forward<args_t>(args)...);
+		}
+		void push(type const& obj) {
+			emplace(obj);
+		}
+
+		bool try_pop(type& obj) {
+			index_t pos;
+			Cell* cell = claim_pop(pos);
+			if (cell)
+				take(cell, pos, obj);
+			return cell;
+		}
+		template <typename rep_t, typename period_t>
+		bool try_pop_for(type& obj, std::chrono::duration<rep_t, period_t> const& timeout) {
+			index_t pos;
+			Cell* cell = wait_for([this](index_t& pos) { return claim_pop(pos); }, pos, timeout);
+			if (cell)
+				take(cell, pos, obj);
+			return cell;
+		}
+		type pop() {
+			index_t pos;
+			Cell* cell = wait_pop(pos);
+			type obj = std::move(*cell->data());
+			cell->data()->~type();
+			publish(cell, pos + mask + 1);
+			return obj;
+		}
+
+		// approximate while other threads are pushing or popping
+		size_t size() const noexcept {
+			index_t head = dequeue_pos.load(std::memory_order_relaxed);
+			index_t tail = enqueue_pos.load(std::memory_order_relaxed);
+			return (tail > head) ? tail - head : 0;
+		}
+		bool empty() const noexcept {
+			return !size();
+		}
+		size_t capacity() const noexcept {
+			return mask + 1;
+		}
+	};
+
+	// Implicit d-ary heap in one contiguous array. top() is the element that
+	// compare puts first, so the default std::less gives a min-heap (earliest
+	// deadline first). A wider node (arity 4 by default) trades a few more
+	// comparisons per level for a shallower tree and fewer cache misses.
+	template <typename type, size_t arity = 4, typename compare = std::less<type>>
+	class DaryHeap final {
+		static_assert(arity >= 2, "A heap node needs at least two children");
+
+		array::Vector<type> elems;
+		[[no_unique_address]] compare before;
+
+		// moves the hole left at index up to where obj belongs
+		void sift_up(index_t index, type obj) {
+			type* base_addr = elems.data();
+			while (index) {
+				index_t parent = (index - 1) / arity;
+				if (!before(obj, base_addr[parent]))
+					break;
+				base_addr[index] = std::move(base_addr[parent]);
+				index = parent;
+			}
+			base_addr[index] = std::move(obj);
+		}
+		void sift_down(index_t index, type obj) {
+			type* base_addr = elems.data();
+			size_t length = elems.size();
+			while (true) {
+				index_t first = index * arity + 1;
+				if (first >= length)
+					break;
+				index_t last = std::min(first + arity, length);
+				index_t best = first;
+				for (index_t child = first + 1; child < last; child++) {
+					if (before(base_addr[child], base_addr[best]))
+						best = child;
+				}
+				if (!before(base_addr[best], obj))
+					break;
+				base_addr[index] = std::move(base_addr[best]);
+				index = best;
+			}
+			base_addr[index] = std::move(obj);
+		}
+	public:
+		DaryHeap(void) = default;
+		explicit DaryHeap(compare const& comp) : before(comp) {}
+		DaryHeap(std::initializer_list<type> const& list) {
+			heapify(list.begin(), list.end());
+		}
+		template <typename iterator_t> DaryHeap(iterator_t first, iterator_t last) {
+			heapify(first, last);
+		}
+		DaryHeap(DaryHeap const& obj) = default;
+		DaryHeap(DaryHeap&& obj) noexcept {
+			swap(obj);
+		}
+		DaryHeap& operator = (DaryHeap obj) noexcept {
+			swap(obj);
+			return *this;
+		}
+
+		// replaces the contents with [first, last) in O(n) (Floyd's construction)
+		template <typename iterator_t> void heapify(iterator_t first, iterator_t last) {
+			elems.clear();
+			if constexpr (std::is_base_of_v<std::forward_iterator_tag,
+				typename std::iterator_traits<iterator_t>::iterator_category>)
+				elems.reserve(static_cast<size_t>(std::distance(first, last)));
+			for (; first != last; ++first)
+				elems.emplace_back(*first);
+			if (elems.size() < 2)
+				return;
+			for (index_t i = (elems.size() - 2) / arity + 1; i--;)
+				sift_down(i, std::move(elems.data()[i]));
+		}
+		template <typename... args_t> void emplace(args_t&&... args) {
+			type& obj = elems.emplace_back(std::forward<args_t>(args)...);
+			sift_up(elems.size() - 1, std::move(obj));
+		}
+		void push(type const& obj) {
+			emplace(obj);
+		}
+		type pop() {
+			if (elems.empty())
+				throw queue_empty_error();
+			type* base_addr = elems.data();
+			type top = std::move(base_addr[0]);
+			type last = std::move(base_addr[elems.size() - 1]);
+			elems.pop_back();
+			if (!elems.empty())
+				sift_down(0, std::move(last));
+			return top;
+		}
+		type const& top() const {
+			if (elems.empty())
+				throw queue_empty_error();
+			return elems.data()[0];
+		}
+		void reserve(size_t size) {
+			elems.reserve(size);
+		}
+		void clear() noexcept {
+			elems.clear();
+		}
+		void swap(DaryHeap& obj) noexcept {
+			elems.swap(obj.elems);
+			std::swap(before, obj.before);
+		}
+		size_t size() const noexcept {
+			return elems.size();
+		}
+		bool empty() const noexcept {
+			return elems.empty();
+		}
+	};
+
+	template <typename type, typename compare = std::less<type>>
+	using BinaryHeap = DaryHeap<type, 2, compare>;
+
+	// Pairing heap with O(1) push and decrease_key and amortized O(log n) pop.
+	// Nodes live in one growable pool and refer to each other by index, so the
+	// handles returned by push() stay valid while the pool grows and freed nodes
+	// are reused without going back to the allocator.
+	template <typename type, typename compare = std::less<type>>
+	class PairingHeap final {
+	public:
+		typedef index_t handle_t;
+		static constexpr handle_t npos = static_cast<handle_t>(-1);
+	private:
+		struct Node {
+			Node(void) {}
+			~Node() {}
+			union {
+				type data;
+				handle_t next_free;
+			};
+			handle_t child = npos;
+			handle_t sibling = npos;
+			// parent if this is the leftmost child, left sibling otherwise
+			handle_t prev = npos;
+			bool live = false;
+		};
+
+		Node* nodes = nullptr;
+		size_t capacity_v = 0;
+		size_t length = 0;
+		handle_t root = npos;
+		handle_t free_head = npos;
+		[[no_unique_address]] compare before;
+
+		handle_t allocate() {
+			if (free_head == npos) {
+				size_t capacity = (capacity_v) ? capacity_v * 2 : 8;
+				Node* addr = new Node[capacity];
+				for (index_t i = 0; i < capacity_v; i++) {
+					addr[i].child = nodes[i].child;
+					addr[i].sibling = nodes[i].sibling;
+					addr[i].prev = nodes[i].prev;
+					addr[i].live = nodes[i].live;
+					if (nodes[i].live) {
+						new (&addr[i].data) type(std::move(nodes[i].data));
+						nodes[i].data.~type();
+					}
+				}
+				for (index_t i = capacity_v; i < capacity; i++)
+					addr[i].next_free = (i + 1 < capacity) ? i + 1 : npos;
+				delete[] nodes;
+				nodes = addr;
+				free_head = capacity_v;
+				capacity_v = capacity;
+			}
+			handle_t handle = free_head;
+			free_head = nodes[handle].next_free;
+			return handle;
+		}
+		void release(handle_t handle) noexcept {
+			Node& node = nodes[handle];
+			node.data.~type();
+			node.live = false;
+			node.next_free = free_head;
+			free_head = handle;
+		}
+		// both a and b must be roots without siblings
+		handle_t meld(handle_t a, handle_t b) noexcept {
+			if (a == npos)
+				return b;
+			if (b == npos)
+				return a;
+			if (before(nodes[b].data, nodes[a].data))
+				std::swap(a, b);
+			nodes[b].prev = a;
+			nodes[b].sibling = nodes[a].child;
+			if (nodes[a].child != npos)
+				nodes[nodes[a].child].prev = b;
+			nodes[a].child = b;
+			nodes[a].prev = npos;
+			return a;
+		}
+		// standard two-pass pairing of a sibling list, done without recursion
+		handle_t merge_pairs(handle_t first) noexcept {
+			handle_t merged = npos;
+			while (first != npos) {
+				handle_t a = first;
+				handle_t b = nodes[a].sibling;
+				first = (b != npos) ? nodes[b].sibling : npos;
+				nodes[a].sibling = nodes[a].prev = npos;
+				if (b != npos)
+					nodes[b].sibling = nodes[b].prev = npos;
+				handle_t pair = meld(a, b);
+				nodes[pair].sibling = merged;
+				merged = pair;
+			}
+			handle_t result = npos;
+			while (merged != npos) {
+				handle_t next = nodes[merged].sibling;
+				nodes[merged].sibling = npos;
+				result = meld(result, merged);
+				merged = next;
+			}
+			return result;
+		}
+		void cut(handle_t handle) noexcept {
+			Node& node = nodes[handle];
+			if (nodes[node.prev].child == handle)
+				nodes[node.prev].child = node.sibling;
+			else
+				nodes[node.prev].sibling = node.sibling;
+			if (node.sibling != npos)
+				nodes[node.sibling].prev = node.prev;
+			node.sibling = node.prev = npos;
+		}
+	public:
+		PairingHeap(void) = default;
+		explicit PairingHeap(compare const& comp) : before(comp) {}
+		PairingHeap(std::initializer_list<type> const& list) {
+			heapify(list.begin(), list.end());
+		}
+		template <typename iterator_t> PairingHeap(iterator_t first, iterator_t last) {
+			heapify(first, last);
+		}
+		PairingHeap(PairingHeap const&) = delete;
+		PairingHeap& operator = (PairingHeap const&) = delete;
+		~PairingHeap() {
+			clear();
+			delete[] nodes;
+		}
+
+		template <typename iterator_t> void heapify(iterator_t first, iterator_t last) {
+			for (; first != last; ++first)
+				push(*first);
+		}
+		template <typename... args_t> handle_t emplace(args_t&&... args) {
+			handle_t handle = allocate();
+			Node& node = nodes[handle];
+			new (&node.data) type(std::forward<args_t>(args)...);
+			node.live = true;
+			node.child = node.sibling = node.prev = npos;
+			root = meld(root, handle);
+			length++;
+			return handle;
+		}
+		handle_t push(type const& obj) {
+			return emplace(obj);
+		}
+		type pop() {
+			if (root == npos)
+				throw queue_empty_error();
+			handle_t old = root;
+			type top = std::move(nodes[old].data);
+			root = merge_pairs(nodes[old].child);
+			release(old);
+			length--;
+			return top;
+		}
+		type const& top() const {
+			if (root == npos)
+				throw queue_empty_error();
+			return nodes[root].data;
+		}
+		type const& get(handle_t handle) const {
+			return nodes[handle].data;
+		}
+		// obj must not compare after the current value of the element
+		void decrease_key(handle_t handle, type const& obj) {
+			if (before(nodes[handle].data, obj))
+				throw invalid_key_error();
+			nodes[handle].data = obj;
+			if (handle == root)
+				return;
+			cut(handle);
+			root = meld(root, handle);
+		}
+		// removes an arbitrary element, e.g. a cancelled timer
+		void erase(handle_t handle) {
+			if (handle == root) {
+				pop();
+				return;
+			}
+			cut(handle);
+			handle_t children = merge_pairs(nodes[handle].child);
+			root = meld(root, children);
+			release(handle);
+			length--;
+		}
+		void clear() noexcept {
+			if constexpr (!std::is_trivially_destructible_v<type>) {
+				for (index_t i = 0; i < capacity_v; i++) {
+					if (nodes[i].live)
+						nodes[i].data.~type();
+				}
+			}
+			for (index_t i = 0; i < capacity_v; i++) {
+				nodes[i].live = false;
+				nodes[i].next_free = (i + 1 < capacity_v) ? i + 1 : npos;
+			}
+			free_head = (capacity_v) ? 0 : npos;
+			root = npos;
+			length = 0;
+		}
+		size_t size() const noexcept {
+			return length;
+		}
+		bool empty() const noexcept {
+			return !length;
+		}
+	};
+
+	// Intrusive hook for TimerWheel. Embed it (usually as a base class) in the
+	// object that owns the timeout; the wheel links the hook itself, so
+	// scheduling and cancelling never allocate.
+	struct Timer {
+		Timer* next = nullptr;
+		Timer* prev = nullptr;
+		uint64_t expires = 0;
+
+		bool scheduled() const noexcept {
+			return next;
+		}
+	};
+
+	// Hierarchical timing wheel (Varghese & Lauck). Level 0 has one bucket per
+	// tick for the next 256 ticks, each upper level covers 64 times the span of
+	// the one below and is cascaded down when the lower level wraps around.
+	// schedule() and cancel() are O(1); advance() expires whole buckets at once.
+	class TimerWheel final {
+		static constexpr unsigned root_bits = 8;
+		static constexpr unsigned level_bits = 6;
+		static constexpr unsigned levels = 4;
+		static constexpr size_t root_size = size_t(1) << root_bits;
+		static constexpr size_t level_size = size_t(1) << level_bits;
+		static constexpr uint64_t max_delay = (uint64_t(1) << (root_bits + level_bits * levels)) - 1;
+
+		Timer root[root_size];
+		Timer tiers[levels][level_size];
+		uint64_t now = 0;
+		size_t length = 0;
+
+		static void reset(Timer& bucket) noexcept {
+			bucket.next = bucket.prev = &bucket;
+		}
+		static void link(Timer& bucket, Timer& timer) noexcept {
+			timer.prev = bucket.prev;
+			timer.next = &bucket;
+			bucket.prev->next = &timer;
+			bucket.prev = &timer;
+		}
+		static void unlink(Timer& timer) noexcept {
+			timer.prev->next = timer.next;
+			timer.next->prev = timer.prev;
+			timer.next = timer.prev = nullptr;
+		}
+		// moves every timer in from to the back of to, leaving from empty
+		static void splice(Timer& to, Timer& from) noexcept {
+			if (from.next == &from)
+				return;
+			from.next->prev = to.prev;
+			to.prev->next = from.next;
+			from.prev->next = &to;
+			to.prev = from.prev;
+			reset(from);
+		}
+		void place(Timer& timer) noexcept {
+			uint64_t delta = (timer.expires > now) ? timer.expires - now : 0;
+			if (delta > max_delay)
+				delta = max_delay;
+			uint64_t when = now + delta;
+			if (delta < root_size) {
+				link(root[when & (root_size - 1)], timer);
+				return;
+			}
+			for (unsigned level = 0; level < levels; level++) {
+				unsigned shift = root_bits + level_bits * level;
+				if (delta < (uint64_t(1) << (shift + level_bits))) {
+					link(tiers[level][(when >> shift) & (level_size - 1)], timer);
+					return;
+				}
+			}
+		}
+		// re-places the timers of one upper bucket, returns the bucket index
+		size_t cascade(unsigned level) noexcept {
+			size_t index = (now >> (root_bits + level_bits * level)) & (level_size - 1);
+			Timer pending;
+			reset(pending);
+			splice(pending, tiers[level][index]);
+			while (pending.next != &pending) {
+				Timer* timer = pending.next;
+				unlink(*timer);
+				place(*timer);
+			}
+			return index;
+		}
+	public:
+		explicit TimerWheel(uint64_t start = 0) : now(start) {
+			for (Timer& bucket : root)
+				reset(bucket);
+			for (auto& level : tiers) {
+				for (Timer& bucket : level)
+					reset(bucket);
+			}
+		}
+		TimerWheel(TimerWheel const&) = delete;
+		TimerWheel& operator = (TimerWheel const&) = delete;
+		~TimerWheel() {
+			auto detach = [](Timer& bucket) {
+				while (bucket.next != &bucket)
+					unlink(*bucket.next);
+			};
+			for (Timer& bucket : root)
+				detach(bucket);
+			for (auto& level : tiers) {
+				for (Timer& bucket : level)
+					detach(bucket);
+			}
+		}
+
+		// fires delay ticks from now, that is in the advance() call that brings
+		// time() to time() + delay; with delay 0 it fires in the next advance(),
+		// even advance(0). An already scheduled timer is rescheduled.
+		void schedule(Timer& timer, uint64_t delay) noexcept {
+			if (timer.scheduled())
+				cancel(timer);
+			timer.expires = now + delay;
+			place(timer);
+			length++;
+		}
+		void cancel(Timer& timer) noexcept {
+			if (!timer.scheduled())
+				return;
+			unlink(timer);
+			length--;
+		}
+		// moves time forward by ticks and calls callback(Timer&) for every timer
+		// that expired on the way; the timer is unlinked before its callback
+		// runs, so the callback may schedule it again
+		template <typename callback_t> size_t advance(uint64_t ticks, callback_t&& callback) {
+			Timer expired;
+			reset(expired);
+			// the bucket of the current tick only holds timers that are already due
+			splice(expired, root[now & (root_size - 1)]);
+			for (uint64_t i = 0; i < ticks; i++) {
+				now++;
+				size_t index = now & (root_size - 1);
+				for (unsigned level = 0; !index && level < levels; level++)
+					index = cascade(level);
+				splice(expired, root[now & (root_size - 1)]);
+			}
+			size_t count = 0;
+			while (expired.next != &expired) {
+				Timer* timer = expired.next;
+				unlink(*timer);
+				length--;
+				count++;
+				callback(*timer);
+			}
+			return count;
+		}
+		uint64_t time() const noexcept {
+			return now;
+		}
+		size_t size() const noexcept {
+			return length;
+		}
+		bool empty() const noexcept {
+			return !length;
+		}
+	};
+
+	// Chase-Lev work-stealing deque, with the memory orderings from Le, Pop,
+	// Cohen & Zappa Nardelli (2013). The owning thread pushes and pops at the
+	// bottom (LIFO), any other thread may steal from the top (FIFO). The ring
+	// grows when full; old rings are kept until destruction because a thief may
+	// still be reading from one. Elements are copied in and out of atomics, so
+	// type must be trivially copyable (typically a task pointer).
+	template <typename type> class WorkStealingDeque final {
+		static_assert(std::is_trivially_copyable_v<type>, "WorkStealingDeque stores trivially copyable values");
+
+		struct Ring {
+			explicit Ring(size_t capacity_p) : capacity(capacity_p) {
+				slots = new std::atomic<type>[capacity];
+			}
+			~Ring() {
+				delete[] slots;
+			}
+			type load(int64_t index) const noexcept {
+				return slots[index & (capacity - 1)].load(std::memory_order_relaxed);
+			}
+			void store(int64_t index, type obj) noexcept {
+				slots[index & (capacity - 1)].store(obj, std::memory_order_relaxed);
+			}
+			size_t capacity;
+			std::atomic<type>* slots;
+			Ring* retired = nullptr;
+		};
+
+		alignas(cache_line_size) std::atomic<int64_t> top = 0;
+		alignas(cache_line_size) std::atomic<int64_t> bottom = 0;
+		alignas(cache_line_size) std::atomic<Ring*> ring;
+	public:
+		explicit WorkStealingDeque(const size_t size = 64) {
+			size_t capacity = 2;
+			while (capacity < size)
+				capacity <<= 1;
+			ring.store(new Ring(capacity), std::memory_order_relaxed);
+		}
+		WorkStealingDeque(WorkStealingDeque const&) = delete;
+		WorkStealingDeque& operator = (WorkStealingDeque const&) = delete;
+		~WorkStealingDeque() {
+			for (Ring* addr = ring.load(std::memory_order_relaxed); addr;) {
+				Ring* next = addr->retired;
+				delete addr;
+				addr = next;
+			}
+		}
+
+		// owner only
+		void push(type obj) {
+			int64_t b = bottom.load(std::memory_order_relaxed);
+			int64_t t = top.load(std::memory_order_acquire);
+			Ring* addr = ring.load(std::memory_order_relaxed);
+			if (b - t > static_cast<int64_t>(addr->capacity) - 1) {
+				Ring* grown = new Ring(addr->capacity * 2);
+				for (int64_t i = t; i < b; i++)
+					grown->store(i, addr->load(i));
+				grown->retired = addr;
+				ring.store(grown, std::memory_order_release);
+				addr = grown;
+			}
+			addr->store(b, obj);
+			std::atomic_thread_fence(std::memory_order_release);
+			bottom.store(b + 1, std::memory_order_relaxed);
+		}
+		// owner only
+		bool pop(type& obj) {
+			int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+			Ring* addr = ring.load(std::memory_order_relaxed);
+			bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t t = top.load(std::memory_order_relaxed);
+			if (t > b) {
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return false;
+			}
+			obj = addr->load(b);
+			if (t == b) {
+				// last element, race the thieves for it
+				bool won = top.compare_exchange_strong(t, t + 1,
+					std::memory_order_seq_cst, std::memory_order_relaxed);
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return won;
+			}
+			return true;
+		}
+		// any thread
+		bool steal(type& obj) {
+			int64_t t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t b = bottom.load(std::memory_order_acquire);
+			if (t >= b)
+				return false;
+			obj = ring.load(std::memory_order_acquire)->load(t);
+			return top.compare_exchange_strong(t, t + 1,
+				std::memory_order_seq_cst, std::memory_order_relaxed);
+		}
+		// only a hint while other threads are stealing
+		size_t size() const noexcept {
+			int64_t b = bottom.load(std::memory_order_relaxed);
+			int64_t t = top.load(std::memory_order_relaxed);
+			return (b > t) ? static_cast<size_t>(b - t) : 0;
+		}
+		bool empty() const noexcept {
+			return !size();
+		}
+	};
 }
\ No newline at end of file
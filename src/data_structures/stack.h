@@ -23,10 +23,28 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <iostream>
 #include <exception>
+#include <memory>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#include <atomic>
+#include <cstdint>
+#include <new>
+
+#include "array.h"
+#include "queue.h"
 
 namespace stack {
 	typedef size_t index_t;
 
+	using queue::cache_line_size;
+
+	struct stack_empty_error : public std::exception {
+		virtual const char* what() const noexcept {
+			return "Stack is empty";
+		}
+	};
+
 	template <typename type> class LinkedStack final {
 		struct Node {
 			Node(type data, Node* ptr) {
@@ -70,11 +88,8 @@ namespace stack {
 		Node* top_ptr = nullptr;
 		size_t length = 0;
 	public:
-		struct stack_empty_error : public std::exception {
-			virtual const char* what() const throw() {
-				return "Stack is empty";
-			}
-		};
+		typedef stack::stack_empty_error stack_empty_error;
+
 		LinkedStack(void) = default;
 		LinkedStack(std::initializer_list<type> const& list) {
 			for (auto const& obj : list) {
@@ -105,9 +120,7 @@ namespace stack {
 			return Iterator(top_ptr);
 		}
 		Iterator end() {
-			Node* addr = top_ptr;
-			for (index_t i = 0; addr; addr = addr->ptr, i++);
-			return Iterator(addr);
+			return Iterator(nullptr);
 		}
 		size_t size() const {
 			return length;
@@ -124,4 +137,220 @@ namespace stack {
 			return os;
 		}
 	};
+
+	// Contiguous stack backed by array::Vector. The first inline_capacity
+	// elements are stored inside the object itself, so small stacks never touch
+	// the heap. Iteration goes from the top down, like LinkedStack.
+	template <typename type, size_t inline_capacity = 0> class ArrayStack final {
+		array::Vector<type, inline_capacity> elems;
+	public:
+		typedef std::reverse_iterator<type*> Iterator;
+
+		ArrayStack(void) = default;
+		ArrayStack(std::initializer_list<type> const& list) : elems(list) {}
+
+		template <typename... args_t> type& emplace(args_t&&... args) {
+			return elems.emplace_back(std::forward<args_t>(args)...);
+		}
+		void push(type const& obj) {
+			elems.push_back(obj);
+		}
+		type pop() {
+			if (elems.empty())
+				throw stack_empty_error();
+			type data = std::move(elems.data()[elems.size() - 1]);
+			elems.pop_back();
+			return data;
+		}
+		type& top() {
+			if (elems.empty())
+				throw stack_empty_error();
+			return elems.data()[elems.size() - 1];
+		}
+		const type& top() const {
+			if (elems.empty())
+				throw stack_empty_error();
+			return elems.data()[elems.size() - 1];
+		}
+		void reserve(size_t size) {
+			elems.reserve(size);
+		}
+		void clear() noexcept {
+			elems.clear();
+		}
+		Iterator begin() noexcept {
+			return Iterator(elems.end());
+		}
+		Iterator end() noexcept {
+			return Iterator(elems.begin());
+		}
+		size_t size() const noexcept {
+			return elems.size();
+		}
+		size_t capacity() const noexcept {
+			return elems.capacity();
+		}
+		bool empty() const noexcept {
+			return elems.empty();
+		}
+		friend auto operator << (std::ostream& os, ArrayStack const& obj) -> std::ostream& {
+			os << "[";
+			for (index_t i = obj.size(); i--;)
+				os << obj.elems.data()[i] << (i ? ", " : "");
+			os << "]";
+			return os;
+		}
+	};
+
+	template <typename type, size_t inline_capacity = 16>
+	using SmallStack = ArrayStack<type, inline_capacity>;
+
+	// Lock-free Treiber stack. The top pointer is packed together with a 16 bit
+	// modification tag into one 64 bit word, so a CAS fails if the top was popped
+	// and pushed again in between (ABA). Popped nodes are never handed back to
+	// the allocator while the stack lives; they go onto an internal free list
+	// (another tagged Treiber stack), which keeps a stale next read by a racing
+	// pop pointing at valid memory. This relies on user-space addresses fitting
+	// in 48 bits, as they do on x86-64 and AArch64.
+	template <typename type> class LockFreeStack final {
+		static_assert(sizeof(void*) == sizeof(uint64_t), "LockFreeStack needs 64 bit pointers");
+
+		struct Node {
+			std::atomic<Node*> next = nullptr;
+			alignas(type) unsigned char storage[sizeof(type)];
+
+			type* data() noexcept {
+				return reinterpret_cast<type*>(storage);
+			}
+		};
+		typedef uint64_t tagged_t;
+		static constexpr unsigned tag_shift = 48;
+		static constexpr tagged_t pointer_mask = (tagged_t(1) << tag_shift) - 1;
+
+		alignas(cache_line_size) std::atomic<tagged_t> top_ptr = 0;
+		alignas(cache_line_size) std::atomic<tagged_t> free_ptr = 0;
+
+		static Node* pointer(tagged_t value) noexcept {
+			return reinterpret_cast<Node*>(static_cast<uintptr_t>(value & pointer_mask));
+		}
+		static tagged_t pack(Node* node, tagged_t previous) noexcept {
+			return static_cast<tagged_t>(reinterpret_cast<uintptr_t>(node)) |
+				(((previous >> tag_shift) + 1) << tag_shift);
+		}
+		// links the chain first..last on top of stack
+		static void link(std::atomic<tagged_t>& stack, Node* first, Node* last) noexcept {
+			tagged_t old = stack.load(std::memory_order_relaxed);
+			do {
+				last->next.store(pointer(old), std::memory_order_relaxed);
+			} while (!stack.compare_exchange_weak(old, pack(first, old),
+				std::memory_order_release, std::memory_order_relaxed));
+		}
+		static Node* unlink(std::atomic<tagged_t>& stack) noexcept {
+			tagged_t old = stack.load(std::memory_order_acquire);
+			while (Node* node = pointer(old)) {
+				Node* next = node->next.load(std::memory_order_relaxed);
+				if (stack.compare_exchange_weak(old, pack(next, old),
+					std::memory_order_acquire, std::memory_order_acquire))
+					return node;
+			}
+			return nullptr;
+		}
+		static Node* create() {
+			Node* node = new Node;
+			if (reinterpret_cast<uintptr_t>(node) & ~static_cast<uintptr_t>(pointer_mask)) {
+				delete node;
+				throw std::bad_alloc();
+			}
+			return node;
+		}
+		Node* allocate() {
+			if (Node* node = unlink(free_ptr))
+				return node;
+			return create();
+		}
+	public:
+		LockFreeStack(void) = default;
+		LockFreeStack(LockFreeStack const&) = delete;
+		LockFreeStack& operator = (LockFreeStack const&) = delete;
+		~LockFreeStack() {
+			for (Node* addr = pointer(top_ptr.load(std::memory_order_acquire)); addr;) {
+				Node* next = addr->next.load(std::memory_order_relaxed);
+				addr->data()->~type();
+				delete addr;
+				addr = next;
+			}
+			for (Node* addr = pointer(free_ptr.load(std::memory_order_acquire)); addr;) {
+				Node* next = addr->next.load(std::memory_order_relaxed);
+				delete addr;
+				addr = next;
+			}
+		}
+
+		template <typename... args_t> void emplace(args_t&&... args) {
+			Node* node = allocate();
+			try {
+				new (node->storage) type(std::forward<args_t>(args)...);
+			}
+			catch (...) {
+				link(free_ptr, node, node);
+				throw;
+			}
+			link(top_ptr, node, node);
+		}
+		void push(type const& obj) {
+			emplace(obj);
+		}
+		bool try_pop(type& obj) {
+			Node* node = unlink(top_ptr);
+			if (!node)
+				return false;
+			obj = std::move(*node->data());
+			node->data()->~type();
+			link(free_ptr, node, node);
+			return true;
+		}
+		// detaches the whole stack with one CAS and calls function(type&&) on
+		// every element from the top down; returns how many there were
+		template <typename function_t> size_t pop_all(function_t&& function) {
+			tagged_t old = top_ptr.load(std::memory_order_relaxed);
+			while (!top_ptr.compare_exchange_weak(old, pack(nullptr, old),
+				std::memory_order_acquire, std::memory_order_relaxed));
+			Node* first = pointer(old);
+			Node* last = nullptr;
+			size_t count = 0;
+			for (Node* addr = first; addr; addr = addr->next.load(std::memory_order_relaxed), count++) {
+				function(std::move(*addr->data()));
+				addr->data()->~type();
+				last = addr;
+			}
+			if (first)
+				link(free_ptr, first, last);
+			return count;
+		}
+		// pre-allocates nodes so that the next size pushes do not allocate
+		// (nodes already on the free list are not counted)
+		void reserve(size_t size) {
+			if (!size)
+				return;
+			Node* first = create();
+			Node* last = first;
+			for (index_t i = 1; i < size; i++) {
+				Node* node;
+				try {
+					node = create();
+				}
+				catch (...) {
+					link(free_ptr, first, last);
+					throw;
+				}
+				node->next.store(first, std::memory_order_relaxed);
+				first = node;
+			}
+			link(free_ptr, first, last);
+		}
+		// only a hint while other threads are pushing or popping
+		bool empty() const noexcept {
+			return !pointer(top_ptr.load(std::memory_order_acquire));
+		}
+	};
 }
\ No newline at end of file
@@ -0,0 +1,257 @@
+﻿/*
+Copyright © 2017-2022 Yılmaz Alpaslan
+
+Permission is hereby granted, free of charge to any person obtaining a copy of this
+software and associated documentation files (the "Software"), to deal in the Software
+without restriction, including without limitation the rights to use, copy, modify,
+merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to the following
+conditions:
+
+The above copyright notice and this permission notice shall be included in all copies
+or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+PARTICULAR PURPOSE AND NOINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <iostream>
+#include <exception>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+
+#include "queue.h"
+
+namespace threadpool {
+	class ThreadPool;
+
+	// A set of tasks spawned on a pool. wait() runs queued tasks itself instead
+	// of blocking, so tasks may spawn and wait on nested groups (fork-join)
+	// without starving the pool. The first exception thrown by a task is
+	// rethrown from wait().
+	class TaskGroup final {
+		friend class ThreadPool;
+
+		ThreadPool& pool;
+		std::atomic<size_t> pending = 0;
+		std::exception_ptr error = nullptr;
+		std::mutex error_lock;
+
+		void fail(std::exception_ptr exc) noexcept {
+			std::lock_guard<std::mutex> guard(error_lock);
+			if (!error)
+				error = exc;
+		}
+		void join() noexcept;
+	public:
+		explicit TaskGroup(ThreadPool& pool_p) : pool(pool_p) {}
+		TaskGroup(TaskGroup const&) = delete;
+		TaskGroup& operator = (TaskGroup const&) = delete;
+		~TaskGroup() {
+			join();
+		}
+
+		template <typename function_t> void run(function_t&& function);
+		void wait() {
+			join();
+			std::lock_guard<std::mutex> guard(error_lock);
+			if (error) {
+				std::exception_ptr exc = error;
+				error = nullptr;
+				std::rethrow_exception(exc);
+			}
+		}
+	};
+
+	// Work-stealing thread pool. Every worker owns a Chase-Lev deque: tasks it
+	// spawns go to the bottom of its own deque and idle workers steal from the
+	// top of the others'. Tasks submitted from outside the pool go through a
+	// shared injection queue. Idle workers park on an epoch counter that every
+	// submission bumps.
+	class ThreadPool final {
+		friend class TaskGroup;
+
+		struct Task {
+			virtual ~Task() = default;
+			virtual void run() = 0;
+			TaskGroup* group = nullptr;
+		};
+		template <typename function_t> struct Job final : Task {
+			explicit Job(function_t&& function_p) : function(std::forward<function_t>(function_p)) {}
+			void run() override {
+				function();
+			}
+			std::decay_t<function_t> function;
+		};
+		struct Worker {
+			queue::WorkStealingDeque<Task*> tasks;
+			std::thread thread;
+		};
+
+		static constexpr unsigned spin_limit = 64;
+		static inline thread_local ThreadPool* current_pool = nullptr;
+		static inline thread_local size_t current_index = 0;
+
+		Worker* workers = nullptr;
+		size_t count = 0;
+		std::mutex injected_lock;
+		queue::ArrayQueue<Task*> injected;
+		std::atomic<size_t> injected_count = 0;
+		alignas(queue::cache_line_size) std::atomic<uint32_t> epoch = 0;
+		std::atomic<uint32_t> sleepers = 0;
+		std::atomic<bool> stopping = false;
+
+		Worker* current() const noexcept {
+			return (current_pool == this) ? &workers[current_index] : nullptr;
+		}
+		void submit(Task* task) {
+			task->group->pending.fetch_add(1, std::memory_order_relaxed);
+			if (Worker* worker = current()) {
+				worker->tasks.push(task);
+			}
+			else {
+				std::lock_guard<std::mutex> guard(injected_lock);
+				injected.push(task);
+				injected_count.fetch_add(1, std::memory_order_relaxed);
+			}
+			epoch.fetch_add(1, std::memory_order_seq_cst);
+			if (sleepers.load(std::memory_order_seq_cst))
+				epoch.notify_one();
+		}
+		Task* find_task() {
+			Task* task = nullptr;
+			Worker* worker = current();
+			if (worker && worker->tasks.pop(task))
+				return task;
+			if (injected_count.load(std::memory_order_relaxed)) {
+				std::lock_guard<std::mutex> guard(injected_lock);
+				if (!injected.empty()) {
+					injected_count.fetch_sub(1, std::memory_order_relaxed);
+					return injected.pop();
+				}
+			}
+			size_t start = (worker) ? current_index + 1 : 0;
+			for (size_t i = 0; i < count; i++) {
+				Worker& victim = workers[(start + i) % count];
+				if (&victim != worker && victim.tasks.steal(task))
+					return task;
+			}
+			return nullptr;
+		}
+		bool has_work() const noexcept {
+			if (injected_count.load(std::memory_order_seq_cst))
+				return true;
+			for (size_t i = 0; i < count; i++) {
+				if (!workers[i].tasks.empty())
+					return true;
+			}
+			return false;
+		}
+		static void execute(Task* task) noexcept {
+			TaskGroup* group = task->group;
+			try {
+				task->run();
+			}
+			catch (...) {
+				group->fail(std::current_exception());
+			}
+			delete task;
+			group->pending.fetch_sub(1, std::memory_order_release);
+		}
+		void work(size_t index) {
+			current_pool = this;
+			current_index = index;
+			for (unsigned spin = 0; !stopping.load(std::memory_order_acquire);) {
+				if (Task* task = find_task()) {
+					execute(task);
+					spin = 0;
+					continue;
+				}
+				if (++spin < spin_limit) {
+					std::this_thread::yield();
+					continue;
+				}
+				uint32_t seen = epoch.load(std::memory_order_seq_cst);
+				sleepers.fetch_add(1, std::memory_order_seq_cst);
+				if (!has_work() && !stopping.load(std::memory_order_seq_cst))
+					epoch.wait(seen, std::memory_order_seq_cst);
+				sleepers.fetch_sub(1, std::memory_order_relaxed);
+				spin = 0;
+			}
+		}
+	public:
+		explicit ThreadPool(size_t threads = std::max(1u, std::thread::hardware_concurrency())) : count(threads) {
+			workers = new Worker[count];
+			for (size_t i = 0; i < count; i++)
+				workers[i].thread = std::thread(&ThreadPool::work, this, i);
+		}
+		ThreadPool(ThreadPool const&) = delete;
+		ThreadPool& operator = (ThreadPool const&) = delete;
+		~ThreadPool() {
+			stopping.store(true, std::memory_order_seq_cst);
+			epoch.fetch_add(1, std::memory_order_seq_cst);
+			epoch.notify_all();
+			for (size_t i = 0; i < count; i++)
+				workers[i].thread.join();
+			delete[] workers;
+		}
+
+		size_t size() const noexcept {
+			return count;
+		}
+		// calls function(i) for every i in [first, last), in chunks of at least
+		// grain iterations, and returns once all of them are done
+		template <typename function_t>
+		void parallel_for(size_t first, size_t last, function_t const& function, size_t grain = 1) {
+			if (first >= last)
+				return;
+			size_t chunks = std::max<size_t>(1, std::min((last - first) / std::max<size_t>(grain, 1), count * 4));
+			size_t step = (last - first + chunks - 1) / chunks;
+			TaskGroup group(*this);
+			for (size_t begin = first; begin < last; begin += step) {
+				size_t end = std::min(begin + step, last);
+				group.run([&function, begin, end] {
+					for (size_t i = begin; i < end; i++)
+						function(i);
+				});
+			}
+			group.wait();
+		}
+	};
+
+	template <typename function_t> void TaskGroup::run(function_t&& function) {
+		auto* task = new ThreadPool::Job<function_t>(std::forward<function_t>(function));
+		task->group = this;
+		pool.submit(task);
+	}
+	inline void TaskGroup::join() noexcept {
+		for (unsigned spin = 0; pending.load(std::memory_order_acquire);) {
+			if (ThreadPool::Task* task = pool.find_task()) {
+				ThreadPool::execute(task);
+				spin = 0;
+			}
+			else if (++spin < ThreadPool::spin_limit) {
+				std::this_thread::yield();
+			}
+			else {
+				std::this_thread::sleep_for(std::chrono::microseconds(50));
+			}
+		}
+	}
+
+	// pool shared by the library's parallel algorithms
+	inline ThreadPool& default_pool() {
+		static ThreadPool pool;
+		return pool;
+	}
+}
\ No newline at end of file
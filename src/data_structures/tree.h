@@ -25,6 +25,11 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <exception>
 #include <algorithm>
 #include <cmath>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 #include "queue.h"
 
@@ -74,10 +79,27 @@ namespace tree {
 			Node* parent = nullptr;
 			Node* left   = nullptr;
 			Node* right  = nullptr;
+			// augmented subtree data, kept up to date by retrace()
+			long height  = 0;
+			size_t size  = 1;
 		};
 
 		Node* root = nullptr;
 
+		static long height_of(const Node* node) noexcept {
+			return node ? node->height : -1;
+		}
+		static size_t size_of(const Node* node) noexcept {
+			return node ? node->size : 0;
+		}
+		// recomputes the augmented data on the path from node up to the root
+		static void retrace(Node* node) noexcept {
+			for (; node; node = node->parent) {
+				node->height = 1 + std::max(height_of(node->left), height_of(node->right));
+				node->size = 1 + size_of(node->left) + size_of(node->right);
+			}
+		}
+
 		Node* find(Node* root, type const& obj) const {
 			while (root && root->data && *root->data != obj)
 				root = ((obj > *root->data) ? root->right : root->left);
@@ -122,42 +144,28 @@ namespace tree {
 				return;
 			}
 			((obj > *prev->data) ? prev->right : prev->left) = node;
+			retrace(prev);
 		}
 		void remove(type const& obj) {
 			Node* node = find(this->root, obj);
-			if (!node->right && !node->left) {
-				((obj > *node->parent->data) ?
-					node->parent->right :
-					node->parent->left) = nullptr;
-				delete node;
-			}
-			else if (!node->right || !node->left) {
-				Node* &link = ((obj > *node->parent->data) ?
-					node->parent->right :
-					node->parent->left);
-				Node* child = (node->right) ? node->right : node->left;
-				link = child;
-				child->parent = node->parent;
-				delete node;
-			}
-			else {
-				Node* temp;
-				free(static_cast<void*>(node->data));
-				if (!node->right->left) {
-					*node->data = min_in_subtree(node->right);
-					temp = node->right;
-					node->right = node->right->right;
-				}
-				else if (node->right->left && !node->left->right) {
-					*node->data = max_in_subtree(node->left);
-					temp = node->left;
-					node->left = node->left->left;
-				}
-				else {
-					throw tree::node_cannot_be_deleted();
-				}
-				delete temp;
+			if (node->left && node->right) {
+				// take the in-order successor's value and unlink the successor instead
+				Node* successor = node->right;
+				while (successor->left)
+					successor = successor->left;
+				*node->data = *successor->data;
+				node = successor;
 			}
+			Node* child = (node->left) ? node->left : node->right;
+			Node* parent = node->parent;
+			if (child)
+				child->parent = parent;
+			if (!parent)
+				this->root = child;
+			else
+				((parent->left == node) ? parent->left : parent->right) = child;
+			delete node;
+			retrace(parent);
 		}
 		long depth_of(type const& obj) const {
 			Node* node = this->root;
@@ -171,24 +179,48 @@ namespace tree {
 			return i;
 		}
 		long height_of(type const& obj) const {
-			queue::LinkedQueue<Node*> q{ find(this->root, obj) };
-			long height = 0;
-			for (size_t size = 1; !q.empty(); height++, size = q.size()) {
-				for (unsigned __int64 i = 0; i < size; i++) {
-					Node* curr = q.front();
-					q.pop();
-					if (curr->left)
-						q.push(curr->left);
-					if (curr->right)
-						q.push(curr->right);
+			return find(this->root, obj)->height;
+		}
+		long height() const noexcept {
+			return height_of(this->root);
+		}
+		size_t size() const noexcept {
+			return size_of(this->root);
+		}
+		bool empty() const noexcept {
+			return !this->root;
+		}
+		// k-th smallest element, counting from 0
+		type& select(index_t k) const {
+			if (k >= size())
+				throw tree::not_found_error();
+			Node* node = this->root;
+			while (true) {
+				size_t left = size_of(node->left);
+				if (k == left)
+					return *node->data;
+				if (k < left) {
+					node = node->left;
+				}
+				else {
+					k -= left + 1;
+					node = node->right;
 				}
 			}
-			return height - 1;
 		}
-		long height() const noexcept {
-			if (!this->root)
-				return -1;
-			return height_of(*this->root->data);
+		// number of elements strictly smaller than obj
+		index_t rank(type const& obj) const {
+			index_t r = 0;
+			for (Node* node = this->root; node;) {
+				if (obj > *node->data) {
+					r += size_of(node->left) + 1;
+					node = node->right;
+				}
+				else {
+					node = node->left;
+				}
+			}
+			return r;
 		}
 		bool has(type const& obj) const {
 			return find(this->root, obj);
@@ -212,7 +244,7 @@ namespace tree {
 			}
 		}
 		friend auto operator << (std::ostream& os, BinarySearchTree const& obj) -> std::ostream& {
-			queue::LinkedQueue<Node*> q{ obj.root };
+			queue::ArrayQueue<Node*> q{ obj.root };
 			unsigned __int64 i = 0;
 			unsigned __int64 l = 1;
 			for (size_t size = 1; !q.empty(); size = q.size()) {
@@ -234,4 +266,436 @@ namespace tree {
 			return os;
 		}
 	};
+
+	// Lazy skip list (Herlihy, Lev, Luchangco & Shavit). Readers never take a lock
+	// or write to shared memory, writers only lock the predecessors they relink.
+	// Removed nodes are unlinked immediately but only freed by reclaim() or the
+	// destructor, since a concurrent reader may still be standing on them.
+	template <typename type> requires tree::supports_comparison<type>
+	class ConcurrentSkipList final {
+		static constexpr int max_level = 32;
+
+		struct SpinLock {
+			std::atomic_flag flag;
+			void lock() noexcept {
+				while (flag.test_and_set(std::memory_order_acquire))
+					flag.wait(true, std::memory_order_relaxed);
+			}
+			void unlock() noexcept {
+				flag.clear(std::memory_order_release);
+				flag.notify_one();
+			}
+		};
+		struct Node {
+			// head sentinel, data is left uninitialized
+			Node(int height_p) : height(height_p) {
+				next = new std::atomic<Node*>[height]();
+			}
+			Node(type const& data_r, int height_p) : data(data_r), height(height_p) {
+				next = new std::atomic<Node*>[height]();
+			}
+			~Node() {
+				delete[] next;
+			}
+			union {
+				type data;
+			};
+			std::atomic<Node*>* next;
+			int height;
+			std::atomic<bool> marked = false;
+			std::atomic<bool> fully_linked = false;
+			SpinLock lock;
+			Node* retired = nullptr;
+		};
+
+		Node* head = new Node(max_level);
+		std::atomic<Node*> retired_addr = nullptr;
+		std::atomic<size_t> length = 0;
+
+		static int random_level() noexcept {
+			thread_local uint64_t state = 0x9E3779B97F4A7C15ull ^
+				reinterpret_cast<uintptr_t>(&state);
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			int level = 1;
+			for (uint64_t bits = state; (bits & 1) && level < max_level; bits >>= 1)
+				level++;
+			return level;
+		}
+		static bool equals(type const& lhs, type const& rhs) {
+			return !(lhs < rhs) && !(lhs > rhs);
+		}
+		int find(type const& obj, Node** preds, Node** succs) const {
+			int found = -1;
+			Node* pred = head;
+			for (int level = max_level - 1; level >= 0; level--) {
+				Node* curr = pred->next[level].load(std::memory_order_acquire);
+				while (curr && curr->data < obj) {
+					pred = curr;
+					curr = pred->next[level].load(std::memory_order_acquire);
+				}
+				if (found == -1 && curr && equals(curr->data, obj))
+					found = level;
+				preds[level] = pred;
+				succs[level] = curr;
+			}
+			return found;
+		}
+		static void unlock_preds(Node** preds, int highest) noexcept {
+			Node* prev = nullptr;
+			for (int level = 0; level <= highest; level++) {
+				if (preds[level] != prev)
+					preds[level]->lock.unlock();
+				prev = preds[level];
+			}
+		}
+		void retire(Node* node) noexcept {
+			node->retired = retired_addr.load(std::memory_order_relaxed);
+			while (!retired_addr.compare_exchange_weak(node->retired, node,
+				std::memory_order_release, std::memory_order_relaxed));
+		}
+		static void destroy(Node* node) noexcept {
+			node->data.~type();
+			delete node;
+		}
+	public:
+		ConcurrentSkipList(void) = default;
+		ConcurrentSkipList(std::initializer_list<type> const& list) {
+			for (auto const& obj : list) {
+				insert(obj);
+			}
+		}
+		ConcurrentSkipList(ConcurrentSkipList const&) = delete;
+		ConcurrentSkipList& operator = (ConcurrentSkipList const&) = delete;
+		~ConcurrentSkipList() {
+			reclaim();
+			for (Node* addr = head->next[0].load(std::memory_order_relaxed); addr;) {
+				Node* next = addr->next[0].load(std::memory_order_relaxed);
+				destroy(addr);
+				addr = next;
+			}
+			delete head;
+		}
+
+		// returns false if an equal element is already present
+		bool insert(type const& obj) {
+			int top = random_level();
+			Node* preds[max_level];
+			Node* succs[max_level];
+			while (true) {
+				int found = find(obj, preds, succs);
+				if (found != -1) {
+					Node* node = succs[found];
+					if (!node->marked.load(std::memory_order_acquire)) {
+						while (!node->fully_linked.load(std::memory_order_acquire))
+							std::this_thread::yield();
+						return false;
+					}
+					continue;
+				}
+				int highest = -1;
+				bool valid = true;
+				for (int level = 0; valid && level < top; level++) {
+					Node* pred = preds[level];
+					Node* succ = succs[level];
+					if (!level || pred != preds[level - 1])
+						pred->lock.lock();
+					highest = level;
+					valid = !pred->marked.load(std::memory_order_acquire) &&
+						(!succ || !succ->marked.load(std::memory_order_acquire)) &&
+						pred->next[level].load(std::memory_order_acquire) == succ;
+				}
+				if (!valid) {
+					unlock_preds(preds, highest);
+					continue;
+				}
+				Node* node = new Node(obj, top);
+				for (int level = 0; level < top; level++)
+					node->next[level].store(succs[level], std::memory_order_relaxed);
+				for (int level = 0; level < top; level++)
+					preds[level]->next[level].store(node, std::memory_order_release);
+				node->fully_linked.store(true, std::memory_order_release);
+				unlock_preds(preds, highest);
+				length.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+		// returns false if no equal element was present
+		bool remove(type const& obj) {
+			Node* preds[max_level];
+			Node* succs[max_level];
+			Node* victim = nullptr;
+			bool marked = false;
+			while (true) {
+				int found = find(obj, preds, succs);
+				if (!marked) {
+					if (found == -1)
+						return false;
+					victim = succs[found];
+					if (!victim->fully_linked.load(std::memory_order_acquire) ||
+						victim->height - 1 != found ||
+						victim->marked.load(std::memory_order_acquire))
+						return false;
+					victim->lock.lock();
+					if (victim->marked.load(std::memory_order_relaxed)) {
+						victim->lock.unlock();
+						return false;
+					}
+					victim->marked.store(true, std::memory_order_release);
+					marked = true;
+				}
+				int highest = -1;
+				bool valid = true;
+				for (int level = 0; valid && level < victim->height; level++) {
+					Node* pred = preds[level];
+					if (!level || pred != preds[level - 1])
+						pred->lock.lock();
+					highest = level;
+					valid = !pred->marked.load(std::memory_order_acquire) &&
+						pred->next[level].load(std::memory_order_acquire) == victim;
+				}
+				if (!valid) {
+					unlock_preds(preds, highest);
+					continue;
+				}
+				for (int level = victim->height - 1; level >= 0; level--)
+					preds[level]->next[level].store(
+						victim->next[level].load(std::memory_order_relaxed),
+						std::memory_order_release);
+				victim->lock.unlock();
+				unlock_preds(preds, highest);
+				length.fetch_sub(1, std::memory_order_relaxed);
+				retire(victim);
+				return true;
+			}
+		}
+		bool has(type const& obj) const {
+			Node* preds[max_level];
+			Node* succs[max_level];
+			int found = find(obj, preds, succs);
+			return found != -1 &&
+				succs[found]->fully_linked.load(std::memory_order_acquire) &&
+				!succs[found]->marked.load(std::memory_order_acquire);
+		}
+		type min() const {
+			for (Node* addr = head->next[0].load(std::memory_order_acquire); addr;
+				addr = addr->next[0].load(std::memory_order_acquire)) {
+				if (addr->fully_linked.load(std::memory_order_acquire) &&
+					!addr->marked.load(std::memory_order_acquire))
+					return addr->data;
+			}
+			throw tree_empty_error();
+		}
+		type max() const {
+			Node* pred = head;
+			for (int level = max_level - 1; level > 0; level--) {
+				for (Node* next = pred->next[level].load(std::memory_order_acquire); next;
+					next = pred->next[level].load(std::memory_order_acquire)) {
+					if (next->marked.load(std::memory_order_acquire))
+						break;
+					pred = next;
+				}
+			}
+			// pred may have been removed after we stepped on it, rescan from head then
+			for (Node* start : { pred, head }) {
+				Node* last = nullptr;
+				for (Node* addr = start->next[0].load(std::memory_order_acquire); addr;
+					addr = addr->next[0].load(std::memory_order_acquire)) {
+					if (addr->fully_linked.load(std::memory_order_acquire) &&
+						!addr->marked.load(std::memory_order_acquire))
+						last = addr;
+				}
+				if (last)
+					return last->data;
+				if (start != head && !start->marked.load(std::memory_order_acquire))
+					return start->data;
+			}
+			throw tree_empty_error();
+		}
+		size_t size() const noexcept {
+			return length.load(std::memory_order_relaxed);
+		}
+		bool empty() const noexcept {
+			return !size();
+		}
+		// frees removed nodes; only call while no other thread is using the list
+		void reclaim() noexcept {
+			Node* addr = retired_addr.exchange(nullptr, std::memory_order_acquire);
+			while (addr) {
+				Node* next = addr->retired;
+				destroy(addr);
+				addr = next;
+			}
+		}
+	};
+
+	// Persistent (path-copying) binary search tree. Nodes are immutable and shared
+	// between versions through reference counting, so snapshot() is a single
+	// reference count increment and an update only copies the path it walked.
+	// Updates publish the new root with a compare-and-swap, so snapshots can be
+	// taken from any thread while writers keep going.
+	template <typename type> requires tree::supports_comparison<type>
+	class PersistentTree final {
+		struct Node;
+		typedef std::shared_ptr<const Node> link_t;
+		struct Node {
+			Node(type const& data_r, link_t left_p, link_t right_p)
+				: data(data_r), left(std::move(left_p)), right(std::move(right_p)) {
+				size = 1 + size_of(left) + size_of(right);
+			}
+			type data;
+			// only mutated when the last owner tears a subtree down, see release()
+			mutable link_t left;
+			mutable link_t right;
+			size_t size;
+		};
+		struct Step {
+			const Node* node;
+			bool right;
+		};
+
+		std::atomic<link_t> root;
+
+		explicit PersistentTree(link_t root_p) : root(std::move(root_p)) {}
+
+		static size_t size_of(link_t const& node) noexcept {
+			return node ? node->size : 0;
+		}
+		static link_t make(type const& data, link_t left, link_t right) {
+			return std::make_shared<const Node>(data, std::move(left), std::move(right));
+		}
+		// copies the walked path bottom-up, hanging child where the walk ended
+		static link_t rebuild(std::vector<Step> const& path, link_t child) {
+			for (size_t i = path.size(); i--;) {
+				const Node* node = path[i].node;
+				child = path[i].right ?
+					make(node->data, node->left, std::move(child)) :
+					make(node->data, std::move(child), node->right);
+			}
+			return child;
+		}
+		static link_t inserted(link_t const& version, type const& obj) {
+			std::vector<Step> path;
+			for (const Node* node = version.get(); node;) {
+				bool right = obj > node->data;
+				path.push_back({ node, right });
+				node = (right ? node->right : node->left).get();
+			}
+			return rebuild(path, make(obj, nullptr, nullptr));
+		}
+		static link_t removed(link_t const& version, type const& obj) {
+			std::vector<Step> path;
+			const Node* node = version.get();
+			while (node && (node->data < obj || node->data > obj)) {
+				bool right = obj > node->data;
+				path.push_back({ node, right });
+				node = (right ? node->right : node->left).get();
+			}
+			if (!node)
+				throw tree::not_found_error();
+			if (!node->left)
+				return rebuild(path, node->right);
+			if (!node->right)
+				return rebuild(path, node->left);
+			std::vector<Step> successor_path;
+			const Node* successor = node->right.get();
+			while (successor->left) {
+				successor_path.push_back({ successor, false });
+				successor = successor->left.get();
+			}
+			return rebuild(path, make(successor->data, node->left,
+				rebuild(successor_path, successor->right)));
+		}
+		// drops a reference without recursing down degenerate (list-like) trees
+		static void release(link_t node) noexcept {
+			std::vector<link_t> pending;
+			while (node) {
+				if (node.use_count() == 1) {
+					// use_count() is a relaxed load; the fence orders the writes
+					// to the children below after the other owners' last reads,
+					// as the control block's own release/acquire would
+					std::atomic_thread_fence(std::memory_order_acquire);
+					if (node->left)
+						pending.push_back(std::move(node->left));
+					if (node->right)
+						pending.push_back(std::move(node->right));
+				}
+				node.reset();
+				if (pending.empty())
+					break;
+				node = std::move(pending.back());
+				pending.pop_back();
+			}
+		}
+		template <typename function_t> void update(function_t const& function) {
+			link_t expected = root.load(std::memory_order_acquire);
+			link_t desired = function(expected);
+			while (!root.compare_exchange_weak(expected, desired,
+				std::memory_order_acq_rel, std::memory_order_acquire)) {
+				release(std::move(desired));
+				desired = function(expected);
+			}
+			release(std::move(expected));
+		}
+	public:
+		PersistentTree(void) = default;
+		PersistentTree(std::initializer_list<type> const& list) {
+			for (auto const& obj : list) {
+				insert(obj);
+			}
+		}
+		PersistentTree(PersistentTree const& obj) : root(obj.root.load(std::memory_order_acquire)) {}
+		PersistentTree& operator = (PersistentTree const& obj) {
+			release(root.exchange(obj.root.load(std::memory_order_acquire), std::memory_order_acq_rel));
+			return *this;
+		}
+		~PersistentTree() {
+			release(root.exchange(nullptr, std::memory_order_acquire));
+		}
+
+		// O(1), the returned version is unaffected by later updates to this one
+		PersistentTree snapshot() const {
+			return PersistentTree(root.load(std::memory_order_acquire));
+		}
+		void insert(type const& obj) {
+			update([&obj](link_t const& version) { return inserted(version, obj); });
+		}
+		void remove(type const& obj) {
+			update([&obj](link_t const& version) { return removed(version, obj); });
+		}
+		bool has(type const& obj) const {
+			link_t version = root.load(std::memory_order_acquire);
+			for (const Node* node = version.get(); node;) {
+				if (!(node->data < obj) && !(node->data > obj))
+					return true;
+				node = ((obj > node->data) ? node->right : node->left).get();
+			}
+			return false;
+		}
+		type max() const {
+			link_t version = root.load(std::memory_order_acquire);
+			const Node* node = version.get();
+			if (!node)
+				throw tree_empty_error();
+			while (node->right)
+				node = node->right.get();
+			return node->data;
+		}
+		type min() const {
+			link_t version = root.load(std::memory_order_acquire);
+			const Node* node = version.get();
+			if (!node)
+				throw tree_empty_error();
+			while (node->left)
+				node = node->left.get();
+			return node->data;
+		}
+		size_t size() const noexcept {
+			return size_of(root.load(std::memory_order_acquire));
+		}
+		bool empty() const noexcept {
+			return !size();
+		}
+	};
 }
\ No newline at end of file
@@ -0,0 +1,75 @@
+// Checks for array.h, run by tests\main.cpp. Tests.vcxproj leaves NDEBUG
+// undefined in every configuration, so the asserts are live in Release too.
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+
+#include "../src/data_structures/array.h"
+
+// padding-free and trivially copyable, but == looks at key only, so the
+// bytes of two equal elements can differ
+struct Keyed {
+	int key;
+	int payload;
+
+	friend bool operator == (const Keyed& a, const Keyed& b) noexcept {
+		return a.key == b.key;
+	}
+	friend bool operator != (const Keyed& a, const Keyed& b) noexcept {
+		return a.key != b.key;
+	}
+};
+
+// one byte class type, must not take the memset/memchr paths
+struct Byte {
+	unsigned char c;
+
+	friend bool operator == (const Byte& a, const Byte& b) noexcept {
+		return (a.c & 0x7f) == (b.c & 0x7f);
+	}
+};
+
+static void test_custom_equality() {
+	array::Array<Keyed, 2> a = { { { 1, 10 }, { 2, 20 } } };
+	array::Array<Keyed, 2> b = { { { 1, 11 }, { 2, 21 } } };
+	assert(a == b);
+	assert(!(a != b));
+	assert(a.find(Keyed{ 2, 0 }) == 1);
+	assert(a.count(Keyed{ 1, 0 }) == 1);
+
+	array::Array<Byte, 8> bytes;
+	bytes.fill(Byte{ 0x81 });
+	assert(bytes.count(Byte{ 0x01 }) == 8);
+	assert(bytes.find(Byte{ 0x01 }) == 0);
+	assert(!bytes.has(Byte{ 0x02 }));
+}
+
+static void test_scalars() {
+	array::Array<unsigned char, 70> a;
+	a.fill(3);
+	a.unchecked_at(42) = 7;
+	assert(a.find(7) == 42 && a.count(3) == 69);
+	assert(a.max() == 7 && a.min() == 3);
+
+	array::Array<unsigned char, 70> b = a;
+	assert(a == b && !(a < b) && a <= b);
+	b.unchecked_at(69) = 4;
+	assert(a != b && a < b && b > a);
+
+	array::Array<double, 2> z = { 0.0, 1.0 };
+	array::Array<double, 2> nz = { -0.0, 1.0 };
+	assert(z == nz);
+
+	array::Array<int32_t, 5> c = { 3, 1, 4, 1, 5 };
+	array::Array<int32_t, 5> d = { 3, 1, 4, 2, 0 };
+	assert(c < d && !(d < c) && c.count(1) == 2 && &c.min() == &c.elems[1]);
+	c.swap(d);
+	assert(c.elems[3] == 2 && d.elems[3] == 1);
+}
+
+void run_array_tests() {
+	test_custom_equality();
+	test_scalars();
+	std::cout << "array tests passed" << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#include <iostream>
+
+void run_array_tests();
+void run_queue_tests();
+
+// Tests.vcxproj runs this after every build, so a failing assert fails the build
+int main(int argc, char* argv[]) {
+	run_array_tests();
+	run_queue_tests();
+	std::cout << "All tests passed" << std::endl;
+	return 0;
+}
\ No newline at end of file
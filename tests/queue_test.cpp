@@ -0,0 +1,46 @@
+// Checks for queue.h, run by tests\main.cpp.
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+
+#include "../src/data_structures/queue.h"
+
+// a timer scheduled with delay d at time s fires in the tick that brings
+// time() to s + d, whichever wheel level it starts on
+static void test_timer_firing_tick() {
+	const uint64_t delays[] = { 1, 5, 255, 256, 300, 16383, 16384, 70000 };
+	const uint64_t starts[] = { 0, 100, 255, 256, 12345 };
+	for (uint64_t start : starts) {
+		for (uint64_t delay : delays) {
+			queue::Timer timer;
+			queue::TimerWheel wheel(start);
+			wheel.schedule(timer, delay);
+			uint64_t fired = 0;
+			while (!fired) {
+				wheel.advance(1, [&](queue::Timer&) {
+					fired = wheel.time();
+				});
+				assert(wheel.time() <= start + delay);
+			}
+			assert(fired == start + delay);
+			assert(wheel.empty());
+		}
+	}
+
+	queue::Timer timer;
+	queue::TimerWheel wheel;
+	wheel.schedule(timer, 0);
+	assert(wheel.advance(0, [](queue::Timer&) {}) == 1);
+	assert(wheel.time() == 0);
+
+	wheel.schedule(timer, 5);
+	assert(wheel.advance(4, [](queue::Timer&) {}) == 0);
+	assert(wheel.advance(1, [](queue::Timer&) {}) == 1);
+	assert(wheel.time() == 5);
+}
+
+void run_queue_tests() {
+	test_timer_firing_tick();
+	std::cout << "queue tests passed" << std::endl;
+}
\ No newline at end of file